@@ -0,0 +1,123 @@
+#include <stdlib.h>
+#include "pool.h"
+#include "spec.h"
+#include "batch.h"
+
+// Solving a state of `size` cards takes time proportional to size^2
+// for streaks, and to size^3 for totals. With a mix of sizes, the few
+// largest decks dominate, and splitting the jobs evenly by number
+// between the workers leaves most of them idle while one finishes the
+// large decks. Instead the jobs are sorted by their estimated cost,
+// largest first, and packed into tasks of about equal cost, small jobs
+// many to a task so that the overhead of a task stays small. The tasks
+// are dealt out to the workers round robin, smallest first. A worker
+// takes the task added last to its own queue (see pool.h), so every
+// worker starts on its largest task, and the small tasks at the front
+// of each queue are what idle workers steal.
+//
+// Every worker solves in its own workspace, sized for the largest
+// deck in the batch, so that no solve allocates memory, and every job
+// writes to its own preallocated output.
+
+// The number of tasks per worker to aim for, so that there is work
+// left to steal at the end.
+#define TASKS_PER_WORKER 16
+
+struct batchTask {
+  struct pricingJob** jobs;
+  int numberJobs;
+  struct specWorkspace** workspaces;
+};
+
+static double estimateCost(struct pricingJob* job) {
+  double size = job->size;
+
+  return job->game->spec.outcomeKind == OUTCOME_TOTAL ? size * size * size : size * size;
+}
+
+static int compareCosts(const void* a, const void* b) {
+  double costA = estimateCost(*(struct pricingJob**) a);
+  double costB = estimateCost(*(struct pricingJob**) b);
+
+  return (costA < costB) - (costA > costB);
+}
+
+static void runBatchTask(void* argument, int worker) {
+  struct batchTask* task = argument;
+  struct specWorkspace* workspace = task->workspaces[worker];
+
+  for (int i = 0; i < task->numberJobs; i++) {
+    struct pricingJob* job = task->jobs[i];
+
+    calculateApproximateSpecProbabilities(job->game,
+                                          workspace,
+                                          job->probabilities,
+                                          job->size,
+                                          job->numberLower);
+  }
+}
+
+void priceBatch(struct workPool* pool, struct pricingJob* jobs, int numberJobs) {
+  int numberWorkers = getNumberWorkers(pool);
+  struct pricingJob** sortedJobs = calloc(numberJobs, sizeof(struct pricingJob*));
+  struct batchTask* tasks = calloc(numberJobs, sizeof(struct batchTask));
+  struct specWorkspace** workspaces = calloc(numberWorkers, sizeof(struct specWorkspace*));
+  double totalCost = 0;
+  int maxStreakSize = 0;
+  int maxTotalSize = 0;
+
+  for (int i = 0; i < numberJobs; i++) {
+    int* maxSize = jobs[i].game->spec.outcomeKind == OUTCOME_TOTAL ? &maxTotalSize : &maxStreakSize;
+
+    sortedJobs[i] = &jobs[i];
+    totalCost += estimateCost(&jobs[i]);
+    *maxSize = jobs[i].size > *maxSize ? jobs[i].size : *maxSize;
+  }
+
+  // A workspace for totals has room for a row per number of correct
+  // predictions, so it also has room for the single row of a streak
+  // of up to maxTotalSize * (maxTotalSize + 1) cards.
+  for (int worker = 0; worker < numberWorkers; worker++) {
+    if ((long) maxTotalSize * (maxTotalSize + 1) >= maxStreakSize + 1) {
+      workspaces[worker] = createSpecWorkspace(maxTotalSize, OUTCOME_TOTAL);
+    } else {
+      workspaces[worker] = createSpecWorkspace(maxStreakSize, OUTCOME_STREAK);
+    }
+  }
+
+  qsort(sortedJobs, numberJobs, sizeof(struct pricingJob*), compareCosts);
+
+  double taskCost = totalCost / (numberWorkers * TASKS_PER_WORKER);
+  int numberTasks = 0;
+
+  for (int first = 0; first < numberJobs;) {
+    struct batchTask* task = &tasks[numberTasks];
+    double cost = 0;
+
+    task->jobs = &sortedJobs[first];
+    task->numberJobs = 0;
+    task->workspaces = workspaces;
+
+    while (first < numberJobs && (task->numberJobs == 0 || cost < taskCost)) {
+      cost += estimateCost(sortedJobs[first]);
+      task->numberJobs++;
+      first++;
+    }
+
+    numberTasks++;
+  }
+
+  for (int i = numberTasks - 1; i >= 0; i--) {
+    submitWork(pool, i, runBatchTask, &tasks[i]);
+  }
+
+  waitForWork(pool);
+
+  for (int worker = 0; worker < numberWorkers; worker++) {
+    freeSpecWorkspace(workspaces[worker]);
+  }
+
+  free(workspaces);
+  free(tasks);
+  free(sortedJobs);
+}
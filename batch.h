@@ -0,0 +1,14 @@
+// Pricing many states at once, of decks of different sizes and under
+// different rules (see spec.h), across the workers of a pool (see
+// pool.h).
+
+struct pricingJob {
+  struct compiledGame* game;
+  int size;
+  int numberLower;
+  // Room for getLengthOfProbabilities(size) probabilities, which the
+  // job writes in double precision.
+  double* probabilities;
+};
+
+void priceBatch(struct workPool* pool, struct pricingJob* jobs, int numberJobs);
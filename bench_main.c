@@ -0,0 +1,213 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "prob.h"
+#include "prob128.h"
+#include "sized.h"
+#include "stream.h"
+#include "spec.h"
+#include "odds.h"
+#include "workload.h"
+
+#define MAX_SIZE 13
+#define COMMISSION 0.03
+#define NUMBER_QUERIES 200000
+#define NUMBER_TRAINING_QUERIES 20000
+#define SEED 0x48694c6f
+#define MAX_BENCHMARKS 16
+#define NUMBER_REPETITIONS 5
+
+// Time each way of pricing the states of a workload of games (see
+// workload.c), and print the mean time per query of each, in
+// nanoseconds. Each is timed several times and the fastest time kept,
+// as other load on the machine only ever makes a run slower. Run as
+// `bench [--train] [baseline]`. With --train, run a shorter workload,
+// as used to collect profiles for the optimised build. With a
+// baseline, the output of an earlier run, also print the speedup over
+// it.
+
+static unsigned long int numerators[MAX_SIZE];
+static unsigned long int denominators[MAX_SIZE];
+static unsigned __int128 wideNumerators[MAX_SIZE];
+static unsigned __int128 wideDenominators[MAX_SIZE];
+static double probabilities[MAX_SIZE];
+static double errors[MAX_SIZE];
+
+// Keep the results observable, so that no work is optimised away.
+static double checksum;
+
+static void priceExactly(struct query* query) {
+  calculateProbabilities(numerators, denominators, query->size, query->numberLower);
+  checksum += numerators[0];
+}
+
+static void priceSized(struct query* query) {
+  calculateSizedProbabilities(numerators, denominators, query->size, query->numberLower);
+  checksum += numerators[0];
+}
+
+static void priceApproximately(struct query* query) {
+  calculateProbabilitiesApproximately(probabilities, errors, query->size, query->numberLower);
+  checksum += probabilities[0];
+}
+
+// Price the ticks of every outcome as the betting guide does.
+static void priceTicks(struct query* query) {
+  int length = getLengthOfProbabilities(query->size);
+  int backTicks[MAX_SIZE];
+  int layTicks[MAX_SIZE];
+  int closeOutcomes[MAX_SIZE];
+  int numberClose = 0;
+
+  calculateProbabilitiesApproximately(probabilities, errors, query->size, query->numberLower);
+
+  for (int i = 0; i < length; i++) {
+    if (!calculateBoundedBackTicks(probabilities[i], errors[i], COMMISSION, &backTicks[i])
+        || !calculateBoundedLayTicks(probabilities[i], errors[i], COMMISSION, &layTicks[i])) {
+      closeOutcomes[numberClose++] = i;
+    }
+  }
+
+  if (numberClose > 0) {
+    calculateSelectedProbabilities(numerators,
+                                   denominators,
+                                   closeOutcomes,
+                                   numberClose,
+                                   query->size,
+                                   query->numberLower);
+
+    for (int k = 0; k < numberClose; k++) {
+      int i = closeOutcomes[k];
+
+      backTicks[i] = calculateExactBackTicks(numerators[k], denominators[k], COMMISSION);
+      layTicks[i] = calculateExactLayTicks(numerators[k], denominators[k], COMMISSION);
+    }
+  }
+
+  for (int i = 0; i < length; i++) {
+    checksum += backTicks[i] + layTicks[i];
+  }
+}
+
+static void priceSelected(struct query* query) {
+  int outcome = getLengthOfProbabilities(query->size) / 2;
+
+  calculateSelectedProbabilities(numerators, denominators, &outcome, 1, query->size, query->numberLower);
+  checksum += numerators[0];
+}
+
+static void priceWide(struct query* query) {
+  calculateWideProbabilities(wideNumerators, wideDenominators, query->size, query->numberLower);
+  checksum += (double) wideNumerators[0];
+}
+
+static struct compiledGame* standardGame;
+
+static void priceSpec(struct query* query) {
+  calculateSpecProbabilities(standardGame, numerators, denominators, query->size, query->numberLower);
+  checksum += numerators[0];
+}
+
+static void priceStreamed(struct query* query) {
+  calculateStreamedProbabilities(probabilities, query->size, query->numberLower);
+  checksum += probabilities[0];
+}
+
+struct benchmark {
+  const char* name;
+  void (*price)(struct query* query);
+};
+
+static struct benchmark benchmarks[] = {
+  { "exact", priceExactly },
+  { "sized", priceSized },
+  { "approximate", priceApproximately },
+  { "ticks", priceTicks },
+  { "selected", priceSelected },
+  { "wide", priceWide },
+  { "spec", priceSpec },
+  { "streamed", priceStreamed }
+};
+
+static double runBenchmark(struct benchmark* benchmark, struct query* queries, int numberQueries) {
+  struct timespec start;
+  struct timespec end;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  for (int i = 0; i < numberQueries; i++) {
+    benchmark->price(&queries[i]);
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  double nanoseconds = (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+
+  return nanoseconds / numberQueries;
+}
+
+// Read the times per query of an earlier run, in the same order.
+static int readBaseline(const char* path, double* baseline) {
+  FILE* file = fopen(path, "r");
+  char name[64];
+  int numberBaseline = 0;
+
+  if (file == NULL) {
+    return 0;
+  }
+
+  while (numberBaseline < MAX_BENCHMARKS
+         && fscanf(file, "%63s %lf", name, &baseline[numberBaseline]) == 2) {
+    numberBaseline++;
+  }
+
+  fclose(file);
+
+  return numberBaseline;
+}
+
+int main(int argc, char** argv) {
+  int numberQueries = NUMBER_QUERIES;
+  int numberBenchmarks = sizeof(benchmarks) / sizeof(struct benchmark);
+  double baseline[MAX_BENCHMARKS];
+  int numberBaseline = 0;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--train") == 0) {
+      numberQueries = NUMBER_TRAINING_QUERIES;
+    } else {
+      numberBaseline = readBaseline(argv[i], baseline);
+    }
+  }
+
+  struct query* queries = calloc(numberQueries, sizeof(struct query));
+  struct gameSpec standardSpec = { MAX_SIZE, DEALER_POLICY_STANDARD, TIE_RULE_HIGHER, OUTCOME_STREAK };
+
+  standardGame = compileGame(&standardSpec);
+
+  generateWorkload(queries, numberQueries, MAX_SIZE, SEED);
+
+  for (int i = 0; i < numberBenchmarks; i++) {
+    double time = runBenchmark(&benchmarks[i], queries, numberQueries);
+
+    for (int repetition = 1; repetition < NUMBER_REPETITIONS; repetition++) {
+      double repeatedTime = runBenchmark(&benchmarks[i], queries, numberQueries);
+
+      time = repeatedTime < time ? repeatedTime : time;
+    }
+
+    if (i < numberBaseline) {
+      printf("%-12s %10.1f %6.2fx\n", benchmarks[i].name, time, baseline[i] / time);
+    } else {
+      printf("%-12s %10.1f\n", benchmarks[i].name, time);
+    }
+  }
+
+  fprintf(stderr, "checksum %g\n", checksum);
+
+  freeCompiledGame(standardGame);
+  free(queries);
+
+  return 0;
+}
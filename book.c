@@ -0,0 +1,256 @@
+#include <stdlib.h>
+#include "odds.h"
+#include "book.h"
+
+// The orders live in one preallocated pool, and are linked into a
+// doubly linked first in first out list at each level of the ladder.
+// Unused orders form a singly linked free list through `next`. Matching
+// and cancelling therefore never allocate, and take constant time,
+// apart from finding the next best level when a level empties. The
+// identifier of an order combines its index in the pool with its
+// generation.
+
+#define NUMBER_LEVELS (BOOK_MAX_TICKS - MIN_ODDS_TICKS + 1)
+#define NO_ORDER -1
+
+struct matchingEngine* createMatchingEngine(int numberBooks,
+                                            int capacity,
+                                            void (*onMatch)(void* context,
+                                                            int book,
+                                                            int backAgent,
+                                                            int layAgent,
+                                                            int ticks,
+                                                            int stake),
+                                            void* context) {
+  struct matchingEngine* engine = malloc(sizeof(struct matchingEngine));
+
+  engine->numberBooks = numberBooks;
+  engine->books = calloc(numberBooks, sizeof(struct orderBook));
+  engine->orders = calloc(capacity, sizeof(struct order));
+  engine->capacity = capacity;
+  engine->onMatch = onMatch;
+  engine->context = context;
+  engine->numberOrders = 0;
+  engine->numberMatches = 0;
+
+  for (int book = 0; book < numberBooks; book++) {
+    for (int side = 0; side < 2; side++) {
+      engine->books[book].levels[side] = malloc(NUMBER_LEVELS * sizeof(struct bookLevel));
+      engine->books[book].bestTicks[side] = 0;
+
+      for (int i = 0; i < NUMBER_LEVELS; i++) {
+        engine->books[book].levels[side][i].head = NO_ORDER;
+        engine->books[book].levels[side][i].tail = NO_ORDER;
+      }
+    }
+  }
+
+  for (int i = 0; i < capacity; i++) {
+    engine->orders[i].next = i + 1 < capacity ? i + 1 : NO_ORDER;
+  }
+
+  engine->freeOrders = capacity > 0 ? 0 : NO_ORDER;
+
+  return engine;
+}
+
+void freeMatchingEngine(struct matchingEngine* engine) {
+  for (int book = 0; book < engine->numberBooks; book++) {
+    free(engine->books[book].levels[SIDE_BACK]);
+    free(engine->books[book].levels[SIDE_LAY]);
+  }
+
+  free(engine->books);
+  free(engine->orders);
+  free(engine);
+}
+
+int getBestTicks(struct matchingEngine* engine, int book, int side) {
+  return engine->books[book].bestTicks[side];
+}
+
+// Is a resting order at `ticks` on its side better than the best?
+// Backers prefer lower odds to be matched first, layers higher odds.
+static int isBetter(int side, int ticks, int bestTicks) {
+  if (bestTicks == 0) {
+    return 1;
+  }
+
+  return side == SIDE_BACK ? ticks < bestTicks : ticks > bestTicks;
+}
+
+// Find the best level with orders on a side, starting from the old best
+// which has just emptied.
+static void updateBestTicks(struct orderBook* book, int side) {
+  int ticks = book->bestTicks[side];
+  int step = side == SIDE_BACK ? 1 : -1;
+
+  while (ticks >= MIN_ODDS_TICKS && ticks <= BOOK_MAX_TICKS) {
+    if (book->levels[side][ticks - MIN_ODDS_TICKS].head != NO_ORDER) {
+      book->bestTicks[side] = ticks;
+      return;
+    }
+
+    ticks += step;
+  }
+
+  book->bestTicks[side] = 0;
+}
+
+static void unlinkOrder(struct matchingEngine* engine, int index) {
+  struct order* order = &engine->orders[index];
+  struct orderBook* book = &engine->books[order->book];
+  struct bookLevel* level = &book->levels[order->side][order->ticks - MIN_ODDS_TICKS];
+
+  if (order->previous != NO_ORDER) {
+    engine->orders[order->previous].next = order->next;
+  } else {
+    level->head = order->next;
+  }
+
+  if (order->next != NO_ORDER) {
+    engine->orders[order->next].previous = order->previous;
+  } else {
+    level->tail = order->previous;
+  }
+
+  order->next = engine->freeOrders;
+  order->stake = 0;
+  order->generation++;
+  engine->freeOrders = index;
+
+  if (level->head == NO_ORDER && book->bestTicks[order->side] == order->ticks) {
+    updateBestTicks(book, order->side);
+  }
+}
+
+static long getOrderIdentifier(struct matchingEngine* engine, int index) {
+  return ((long) engine->orders[index].generation << 32) | index;
+}
+
+static long restOrder(struct matchingEngine* engine, int bookIndex, int agent, int side, int ticks, int stake) {
+  int index = engine->freeOrders;
+
+  if (index == NO_ORDER) {
+    return NO_ORDER;
+  }
+
+  struct order* order = &engine->orders[index];
+  struct orderBook* book = &engine->books[bookIndex];
+  struct bookLevel* level = &book->levels[side][ticks - MIN_ODDS_TICKS];
+
+  engine->freeOrders = order->next;
+  order->next = NO_ORDER;
+  order->previous = level->tail;
+  order->agent = agent;
+  order->side = side;
+  order->ticks = ticks;
+  order->stake = stake;
+  order->book = bookIndex;
+
+  if (level->tail != NO_ORDER) {
+    engine->orders[level->tail].next = index;
+  } else {
+    level->head = index;
+  }
+
+  level->tail = index;
+
+  if (isBetter(side, ticks, book->bestTicks[side])) {
+    book->bestTicks[side] = ticks;
+  }
+
+  return getOrderIdentifier(engine, index);
+}
+
+// Can an incoming order on `side` at `ticks` match a resting order on
+// the other side at `restingTicks`?
+static int crosses(int side, int ticks, int restingTicks) {
+  if (restingTicks == 0) {
+    return 0;
+  }
+
+  return side == SIDE_BACK ? restingTicks >= ticks : restingTicks <= ticks;
+}
+
+// Match as much of an incoming order as possible, returning the stake
+// which remains.
+static int matchOrder(struct matchingEngine* engine, int bookIndex, int agent, int side, int ticks, int stake) {
+  struct orderBook* book = &engine->books[bookIndex];
+  int otherSide = 1 - side;
+
+  while (stake > 0 && crosses(side, ticks, book->bestTicks[otherSide])) {
+    int restingTicks = book->bestTicks[otherSide];
+    int index = book->levels[otherSide][restingTicks - MIN_ODDS_TICKS].head;
+    struct order* resting = &engine->orders[index];
+    int matched = resting->stake < stake ? resting->stake : stake;
+    int backAgent = side == SIDE_BACK ? agent : resting->agent;
+    int layAgent = side == SIDE_BACK ? resting->agent : agent;
+
+    stake -= matched;
+    resting->stake -= matched;
+    engine->numberMatches++;
+
+    if (resting->stake == 0) {
+      unlinkOrder(engine, index);
+    }
+
+    if (engine->onMatch != NULL) {
+      engine->onMatch(engine->context, bookIndex, backAgent, layAgent, restingTicks, matched);
+    }
+  }
+
+  return stake;
+}
+
+static int isOnLadder(int ticks) {
+  return ticks >= MIN_ODDS_TICKS && ticks <= BOOK_MAX_TICKS;
+}
+
+long submitOrder(struct matchingEngine* engine, int book, int agent, int side, int ticks, int stake) {
+  if (!isOnLadder(ticks) || stake <= 0) {
+    return NO_ORDER;
+  }
+
+  engine->numberOrders++;
+
+  int remaining = matchOrder(engine, book, agent, side, ticks, stake);
+
+  if (remaining == 0) {
+    return NO_ORDER;
+  }
+
+  return restOrder(engine, book, agent, side, ticks, remaining);
+}
+
+int submitImmediateOrder(struct matchingEngine* engine, int book, int agent, int side, int ticks, int stake) {
+  if (!isOnLadder(ticks) || stake <= 0) {
+    return 0;
+  }
+
+  engine->numberOrders++;
+
+  return stake - matchOrder(engine, book, agent, side, ticks, stake);
+}
+
+void cancelOrder(struct matchingEngine* engine, long order) {
+  if (order == NO_ORDER) {
+    return;
+  }
+
+  int index = order & 0xffffffff;
+
+  if (getOrderIdentifier(engine, index) == order && engine->orders[index].stake > 0) {
+    unlinkOrder(engine, index);
+  }
+}
+
+void clearBook(struct matchingEngine* engine, int bookIndex) {
+  struct orderBook* book = &engine->books[bookIndex];
+
+  for (int side = 0; side < 2; side++) {
+    while (book->bestTicks[side] != 0) {
+      unlinkOrder(engine, book->levels[side][book->bestTicks[side] - MIN_ODDS_TICKS].head);
+    }
+  }
+}
@@ -0,0 +1,86 @@
+// A price time priority matching engine for the outcome markets. Each
+// book holds the unmatched back and lay orders of one outcome, on the
+// tick ladder from MIN_ODDS_TICKS up to BOOK_MAX_TICKS (see odds.h).
+//
+// A back order at some odds matches lay orders at the same or higher
+// odds, and a lay order matches back orders at the same or lower odds.
+// Matches happen at the odds of the order which was already resting,
+// best odds first, and oldest order first at equal odds.
+
+// Far short of MAX_ODDS_TICKS, to keep the levels of every book small;
+// orders above it are rejected.
+#define BOOK_MAX_TICKS 5000
+
+#define SIDE_BACK 0
+#define SIDE_LAY 1
+
+struct order {
+  int next;
+  int previous;
+  int agent;
+  int side;
+  int ticks;
+  int stake;
+  int book;
+  // Incremented each time the order is reused, so that stale
+  // identifiers can be told apart.
+  int generation;
+};
+
+struct bookLevel {
+  int head;
+  int tail;
+};
+
+struct orderBook {
+  struct bookLevel* levels[2];
+  // The lowest odds of a resting back order, and the highest odds of a
+  // resting lay order, or 0 if there are none.
+  int bestTicks[2];
+};
+
+struct matchingEngine {
+  int numberBooks;
+  struct orderBook* books;
+  struct order* orders;
+  int capacity;
+  int freeOrders;
+  // Called for each match, with the agents on both sides.
+  void (*onMatch)(void* context, int book, int backAgent, int layAgent, int ticks, int stake);
+  void* context;
+  long numberOrders;
+  long numberMatches;
+};
+
+// `capacity` is the largest number of orders which may rest in all
+// books at once.
+struct matchingEngine* createMatchingEngine(int numberBooks,
+                                            int capacity,
+                                            void (*onMatch)(void* context,
+                                                            int book,
+                                                            int backAgent,
+                                                            int layAgent,
+                                                            int ticks,
+                                                            int stake),
+                                            void* context);
+
+void freeMatchingEngine(struct matchingEngine* engine);
+
+// Match an order against the book, and rest what remains unmatched.
+// Returns the identifier of the resting order, or -1 if it was fully
+// matched, or rejected because its odds are off the ladder or the
+// engine is full.
+long submitOrder(struct matchingEngine* engine, int book, int agent, int side, int ticks, int stake);
+
+// Match an order against the book without resting what remains.
+// Returns the stake which was matched.
+int submitImmediateOrder(struct matchingEngine* engine, int book, int agent, int side, int ticks, int stake);
+
+// Cancel what remains of an order. Does nothing if the order has been
+// fully matched or cancelled already.
+void cancelOrder(struct matchingEngine* engine, long order);
+
+// Cancel every order in a book.
+void clearBook(struct matchingEngine* engine, int book);
+
+int getBestTicks(struct matchingEngine* engine, int book, int side);
@@ -0,0 +1,307 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "cache.h"
+
+// The file starts with a header, followed by an index of `capacity`
+// slots and then the results themselves, each aligned to 8 bytes. The
+// index is an open addressing hash table over a 64 bit hash of the
+// key, probed linearly, in which an empty slot has a hash of 0. The
+// full key is kept in the slot too, so that colliding hashes are
+// told apart.
+//
+// A result is appended to the end of the file before its slot is
+// written, so that a run which stops part way through storing leaves
+// at worst some unreachable bytes. Once the index is half full, the
+// whole file is rewritten with an index twice as large into a
+// temporary file, which is then renamed over the old one.
+
+#define CACHE_MAGIC "HILOCACH"
+#define CACHE_VERSION 1
+#define INITIAL_CAPACITY 1024
+
+struct cacheHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t capacity;
+  uint64_t numberEntries;
+  uint64_t dataEnd;
+};
+
+struct cacheSlot {
+  uint64_t hash;
+  int32_t size;
+  int32_t numberLower;
+  int32_t dealerPolicy;
+  int32_t tieRule;
+  uint64_t offset;
+  uint64_t length;
+};
+
+static struct cacheHeader* getHeader(struct resultCache* cache) {
+  return (struct cacheHeader*) cache->map;
+}
+
+static struct cacheSlot* getSlots(struct resultCache* cache) {
+  return (struct cacheSlot*) (cache->map + sizeof(struct cacheHeader));
+}
+
+static uint64_t getDataStart(uint32_t capacity) {
+  return sizeof(struct cacheHeader) + (uint64_t) capacity * sizeof(struct cacheSlot);
+}
+
+static uint64_t alignLength(uint64_t length) {
+  return (length + 7) & ~(uint64_t) 7;
+}
+
+// FNV-1a over the fields of the key. 0 marks an empty slot, so it is
+// never used as a hash.
+static uint64_t hashKey(struct cacheKey* key) {
+  int32_t fields[4] = {key->size, key->numberLower, key->dealerPolicy, key->tieRule};
+  unsigned char* bytes = (unsigned char*) fields;
+  uint64_t hash = 14695981039346656037ULL;
+
+  for (size_t i = 0; i < sizeof(fields); i++) {
+    hash = (hash ^ bytes[i]) * 1099511628211ULL;
+  }
+
+  return hash == 0 ? 1 : hash;
+}
+
+static int isSameKey(struct cacheSlot* slot, uint64_t hash, struct cacheKey* key) {
+  return slot->hash == hash
+    && slot->size == key->size
+    && slot->numberLower == key->numberLower
+    && slot->dealerPolicy == key->dealerPolicy
+    && slot->tieRule == key->tieRule;
+}
+
+// The slot holding `key`, or the empty slot where it would go.
+static struct cacheSlot* findSlot(struct cacheSlot* slots, uint32_t capacity, uint64_t hash, struct cacheKey* key) {
+  uint32_t index = hash & (capacity - 1);
+
+  while (slots[index].hash != 0 && !isSameKey(&slots[index], hash, key)) {
+    index = (index + 1) & (capacity - 1);
+  }
+
+  return &slots[index];
+}
+
+// Map the first `length` bytes of the file, growing it if needed.
+static int mapCache(struct resultCache* cache, size_t length) {
+  if (cache->map != NULL) {
+    munmap(cache->map, cache->mapLength);
+    cache->map = NULL;
+  }
+
+  struct stat status;
+
+  if (fstat(cache->descriptor, &status) != 0
+      || ((size_t) status.st_size < length && ftruncate(cache->descriptor, length) != 0)) {
+    return 0;
+  }
+
+  if ((size_t) status.st_size > length) {
+    length = status.st_size;
+  }
+
+  void* map = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, cache->descriptor, 0);
+
+  if (map == MAP_FAILED) {
+    return 0;
+  }
+
+  cache->map = map;
+  cache->mapLength = length;
+
+  return 1;
+}
+
+static void initialiseHeader(struct cacheHeader* header, uint32_t capacity) {
+  memcpy(header->magic, CACHE_MAGIC, sizeof(header->magic));
+  header->version = CACHE_VERSION;
+  header->capacity = capacity;
+  header->numberEntries = 0;
+  header->dataEnd = getDataStart(capacity);
+}
+
+// The index is probed with a mask, so its capacity must be a power
+// of 2.
+static int isCache(struct resultCache* cache) {
+  struct cacheHeader* header = getHeader(cache);
+
+  return cache->mapLength >= sizeof(struct cacheHeader)
+    && memcmp(header->magic, CACHE_MAGIC, sizeof(header->magic)) == 0
+    && header->version == CACHE_VERSION
+    && header->capacity != 0
+    && (header->capacity & (header->capacity - 1)) == 0
+    && header->dataEnd >= getDataStart(header->capacity)
+    && cache->mapLength >= header->dataEnd;
+}
+
+struct resultCache* openResultCache(const char* path) {
+  struct resultCache* cache = malloc(sizeof(struct resultCache));
+
+  cache->descriptor = open(path, O_RDWR | O_CREAT, 0644);
+  cache->path = strdup(path);
+  cache->map = NULL;
+  cache->mapLength = 0;
+
+  struct stat status;
+
+  if (cache->descriptor < 0 || fstat(cache->descriptor, &status) != 0) {
+    closeResultCache(cache);
+    return NULL;
+  }
+
+  int created = status.st_size == 0;
+
+  if (!mapCache(cache, created ? getDataStart(INITIAL_CAPACITY) : (size_t) status.st_size)) {
+    closeResultCache(cache);
+    return NULL;
+  }
+
+  if (created) {
+    initialiseHeader(getHeader(cache), INITIAL_CAPACITY);
+  } else if (!isCache(cache)) {
+    closeResultCache(cache);
+    return NULL;
+  }
+
+  return cache;
+}
+
+void closeResultCache(struct resultCache* cache) {
+  if (cache->map != NULL) {
+    munmap(cache->map, cache->mapLength);
+  }
+
+  if (cache->descriptor >= 0) {
+    close(cache->descriptor);
+  }
+
+  free(cache->path);
+  free(cache);
+}
+
+const void* findCachedResult(struct resultCache* cache, struct cacheKey* key, size_t* length) {
+  struct cacheHeader* header = getHeader(cache);
+  uint64_t hash = hashKey(key);
+  struct cacheSlot* slot = findSlot(getSlots(cache), header->capacity, hash, key);
+
+  if (slot->hash == 0) {
+    return NULL;
+  }
+
+  *length = slot->length;
+
+  return cache->map + slot->offset;
+}
+
+// Rewrite the cache with twice the capacity. Every result moves by the
+// growth of the index, so the results are copied in one block and
+// their offsets shifted.
+static int growResultCache(struct resultCache* cache) {
+  struct cacheHeader* header = getHeader(cache);
+  uint32_t capacity = header->capacity * 2;
+  uint64_t shift = getDataStart(capacity) - getDataStart(header->capacity);
+  uint64_t dataLength = header->dataEnd - getDataStart(header->capacity);
+  size_t pathLength = strlen(cache->path);
+  char* temporaryPath = malloc(pathLength + 5);
+
+  memcpy(temporaryPath, cache->path, pathLength);
+  memcpy(temporaryPath + pathLength, ".tmp", 5);
+
+  struct resultCache* grown = malloc(sizeof(struct resultCache));
+
+  grown->descriptor = open(temporaryPath, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  grown->path = temporaryPath;
+  grown->map = NULL;
+  grown->mapLength = 0;
+
+  if (grown->descriptor < 0 || !mapCache(grown, getDataStart(capacity) + dataLength)) {
+    unlink(temporaryPath);
+    closeResultCache(grown);
+    return 0;
+  }
+
+  struct cacheHeader* grownHeader = getHeader(grown);
+  struct cacheSlot* slots = getSlots(cache);
+
+  initialiseHeader(grownHeader, capacity);
+  memcpy(grown->map + getDataStart(capacity), cache->map + getDataStart(header->capacity), dataLength);
+
+  for (uint32_t i = 0; i < header->capacity; i++) {
+    if (slots[i].hash != 0) {
+      struct cacheKey key = {slots[i].size, slots[i].numberLower, slots[i].dealerPolicy, slots[i].tieRule};
+      struct cacheSlot* slot = findSlot(getSlots(grown), capacity, slots[i].hash, &key);
+
+      *slot = slots[i];
+      slot->offset += shift;
+    }
+  }
+
+  grownHeader->numberEntries = header->numberEntries;
+  grownHeader->dataEnd = header->dataEnd + shift;
+
+  if (msync(grown->map, grown->mapLength, MS_SYNC) != 0 || rename(temporaryPath, cache->path) != 0) {
+    unlink(temporaryPath);
+    closeResultCache(grown);
+    return 0;
+  }
+
+  // Swap the grown file into `cache`, and close the old one.
+  int descriptor = cache->descriptor;
+  unsigned char* map = cache->map;
+  size_t mapLength = cache->mapLength;
+
+  cache->descriptor = grown->descriptor;
+  cache->map = grown->map;
+  cache->mapLength = grown->mapLength;
+  grown->descriptor = descriptor;
+  grown->map = map;
+  grown->mapLength = mapLength;
+
+  closeResultCache(grown);
+
+  return 1;
+}
+
+int storeCachedResult(struct resultCache* cache, struct cacheKey* key, const void* result, size_t length) {
+  if (2 * (getHeader(cache)->numberEntries + 1) > getHeader(cache)->capacity
+      && !growResultCache(cache)) {
+    return 0;
+  }
+
+  uint64_t offset = getHeader(cache)->dataEnd;
+  uint64_t dataEnd = offset + alignLength(length);
+
+  if (dataEnd > cache->mapLength && !mapCache(cache, dataEnd + dataEnd / 2)) {
+    return 0;
+  }
+
+  struct cacheHeader* header = getHeader(cache);
+  uint64_t hash = hashKey(key);
+  struct cacheSlot* slot = findSlot(getSlots(cache), header->capacity, hash, key);
+
+  memcpy(cache->map + offset, result, length);
+  header->dataEnd = dataEnd;
+
+  if (slot->hash == 0) {
+    header->numberEntries++;
+  }
+
+  slot->size = key->size;
+  slot->numberLower = key->numberLower;
+  slot->dealerPolicy = key->dealerPolicy;
+  slot->tieRule = key->tieRule;
+  slot->offset = offset;
+  slot->length = length;
+  slot->hash = hash;
+
+  return 1;
+}
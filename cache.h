@@ -0,0 +1,36 @@
+#include <stddef.h>
+#include <stdint.h>
+
+// A persistent cache of solved results, in a single file which is
+// mapped into memory, so that results solved by earlier runs can be
+// read back without copying. Results are keyed by the rules of the
+// game as well as the state, so that variants do not collide. The
+// dealer policy and tie rule take the values in spec.h.
+
+struct cacheKey {
+  int size;
+  int numberLower;
+  int dealerPolicy;
+  int tieRule;
+};
+
+struct resultCache {
+  int descriptor;
+  char* path;
+  unsigned char* map;
+  size_t mapLength;
+};
+
+// Open the cache at `path`, creating it if it does not exist. Return
+// NULL if the file cannot be opened or is not a cache.
+struct resultCache* openResultCache(const char* path);
+
+void closeResultCache(struct resultCache* cache);
+
+// The result stored for `key`, or NULL if there is none. The result
+// lives in the mapped file, and stays valid until the next store.
+const void* findCachedResult(struct resultCache* cache, struct cacheKey* key, size_t* length);
+
+// Store a copy of `result` for `key`, replacing any result stored for
+// it before. Return 1 on success and 0 if the file cannot be written.
+int storeCachedResult(struct resultCache* cache, struct cacheKey* key, const void* result, size_t length);
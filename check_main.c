@@ -0,0 +1,458 @@
+#include <stdio.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <float.h>
+#include <math.h>
+#include "prob.h"
+#include "prob128.h"
+#include "sized.h"
+#include "correct.h"
+#include "range.h"
+#include "spec.h"
+#include "state.h"
+#include "hidden.h"
+#include "stream.h"
+#include "rng.h"
+#include "pool.h"
+#include "batch.h"
+#include "numa.h"
+
+#define MAX_SIZE 13
+#define RELATIVE_TOLERANCE 1e-12
+#define NUMBER_BATCH_JOBS 20000
+#define MAX_BATCH_SIZE 1000
+#define SEED 0x48694c6f
+#define NUMBER_FAKE_NODES 2
+#define READERS_PER_NODE 2
+#define NUMBER_UPDATES 50
+
+// Check the exact engines against `calculateProbabilities` in prob.c,
+// the reference solution, over every state of a deck of up to
+// MAX_SIZE cards, the largest for which its counts fit. The engines
+// for larger decks are checked further, up to MAX_SIZED_SIZE cards,
+// against the sized solvers once those have been checked against
+// prob.c. Print the number of states on which each engine disagrees,
+// and exit with 1 if any does. Run by `make check`.
+//
+// Batches are checked separately, as a mix of games and of decks of up
+// to MAX_BATCH_SIZE cards, against the exact spec engine where it
+// applies and the streamed engine otherwise. So are replicated tables,
+// by readers on a fake topology of NUMBER_FAKE_NODES nodes while the
+// table is updated over and over.
+
+static unsigned long int numerators[MAX_SIZED_SIZE];
+static unsigned long int denominators[MAX_SIZED_SIZE];
+static struct correctTable* correctTable;
+static struct rangeTable* rangeTable;
+static struct compiledGame* standardGame;
+static struct specWorkspace* standardWorkspace;
+static struct outcomeTable* outcomeTable;
+
+// Do the probabilities of a state agree with the reference ones in
+// `numerators` and `denominators`, as fractions in lowest terms?
+static int agreeExactly(unsigned long int* checkedNumerators,
+                        unsigned long int* checkedDenominators,
+                        int size) {
+  for (int n = 0; n < getLengthOfProbabilities(size); n++) {
+    if (checkedNumerators[n] != numerators[n] || checkedDenominators[n] != denominators[n]) {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+static int checkSized(int size, int numberLower) {
+  unsigned long int sizedNumerators[MAX_SIZE];
+  unsigned long int sizedDenominators[MAX_SIZE];
+
+  calculateSizedProbabilities(sizedNumerators, sizedDenominators, size, numberLower);
+
+  return agreeExactly(sizedNumerators, sizedDenominators, size);
+}
+
+// The number of ways to deal the whole deck, out of which the tables
+// count.
+static unsigned long int getNumberShuffles(int size) {
+  unsigned long int numberShuffles = 1;
+
+  for (int m = 2; m <= size; m++) {
+    numberShuffles *= m;
+  }
+
+  return numberShuffles;
+}
+
+// Does count / size! equal the reference probability of the outcome
+// at index n? Both sides fit 128 bits, so they are compared exactly.
+static int agreesWithCount(unsigned long int count, int size, int n) {
+  return (unsigned __int128) count * denominators[n]
+    == (unsigned __int128) numerators[n] * getNumberShuffles(size);
+}
+
+// The totals of correct predictions cover every way to deal the deck,
+// and all of the deals are correct exactly when the last outcome is.
+static int checkCorrect(int size, int numberLower) {
+  unsigned long int* counts = getCorrectCounts(correctTable, size, numberLower);
+  unsigned long int total = 0;
+
+  for (int numberCorrect = 0; numberCorrect < size; numberCorrect++) {
+    total += counts[numberCorrect];
+  }
+
+  return total == getNumberShuffles(size)
+    && agreesWithCount(counts[size - 1], size, getLengthOfProbabilities(size) - 1);
+}
+
+// A streak of at least (n + 1), up to the longest possible, is the
+// outcome at index n.
+static int checkRange(int size, int numberLower) {
+  int lengthOfProbabilities = getLengthOfProbabilities(size);
+
+  for (int n = 0; n < lengthOfProbabilities; n++) {
+    unsigned long int count = getStreakRangeCount(rangeTable, size, numberLower, n + 1, lengthOfProbabilities + 1);
+
+    if (!agreesWithCount(count, size, n)) {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+// Does a double probability agree with a reference one to within
+// RELATIVE_TOLERANCE, or to within `floor` for the smallest? The
+// streamed engine gives 0 for probabilities below DBL_MIN, so those
+// agree with anything as small.
+static int agreesWithin(double probability, double reference, double floor) {
+  return fabs(probability - reference) <= RELATIVE_TOLERANCE * reference + floor;
+}
+
+// Do the first `length` double probabilities agree with the reference
+// ones?
+static int agreeApproximately(double* probabilities, int length) {
+  for (int n = 0; n < length; n++) {
+    if (!agreesWithin(probabilities[n], (double) numerators[n] / denominators[n], DBL_MIN)) {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+static int checkWide(int size, int numberLower) {
+  unsigned __int128 wideNumerators[MAX_SIZED_SIZE];
+  unsigned __int128 wideDenominators[MAX_SIZED_SIZE];
+
+  if (!calculateWideProbabilities(wideNumerators, wideDenominators, size, numberLower)) {
+    return 0;
+  }
+
+  for (int n = 0; n < getLengthOfProbabilities(size); n++) {
+    if (wideNumerators[n] != numerators[n] || wideDenominators[n] != denominators[n]) {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+static int checkStreamed(int size, int numberLower) {
+  double probabilities[MAX_SIZED_SIZE];
+
+  calculateStreamedProbabilities(probabilities, size, numberLower);
+
+  return agreeApproximately(probabilities, getLengthOfProbabilities(size));
+}
+
+// The standard game, compiled from its spec, in both the exact and
+// the double precision engine.
+static int checkSpec(int size, int numberLower) {
+  unsigned long int specNumerators[MAX_SIZED_SIZE];
+  unsigned long int specDenominators[MAX_SIZED_SIZE];
+  double probabilities[MAX_SIZED_SIZE];
+
+  calculateSpecProbabilities(standardGame, specNumerators, specDenominators, size, numberLower);
+  calculateApproximateSpecProbabilities(standardGame, standardWorkspace, probabilities, size, numberLower);
+
+  return agreeExactly(specNumerators, specDenominators, size) && agreeApproximately(probabilities, getLengthOfProbabilities(size));
+}
+
+// With no cards hidden, either dealer plays the standard game. With
+// cards hidden from a dealer who does not see them either, the
+// outcomes are those of the standard game, cut short.
+static int checkHidden(int size, int numberLower) {
+  double probabilities[MAX_SIZE];
+  int lengthOfProbabilities = getLengthOfProbabilities(size);
+
+  for (int dealerSees = 0; dealerSees <= 1; dealerSees++) {
+    calculateHiddenProbabilities(outcomeTable, probabilities, size, numberLower, 0, dealerSees);
+
+    if (!agreeApproximately(probabilities, lengthOfProbabilities)) {
+      return 0;
+    }
+  }
+
+  for (int numberHidden = 1; numberHidden < size; numberHidden++) {
+    int length = getLengthOfHiddenProbabilities(size, numberHidden);
+
+    calculateHiddenProbabilities(outcomeTable, probabilities, size, numberLower, numberHidden, 0);
+
+    if (!agreeApproximately(probabilities, length < lengthOfProbabilities ? length : lengthOfProbabilities)) {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+// Each engine is checked on the decks of up to `maxSize` cards.
+struct check {
+  const char* name;
+  int (*agrees)(int size, int numberLower);
+  int maxSize;
+};
+
+static struct check checks[] = {
+  { "sized", checkSized, MAX_SIZE },
+  { "correct", checkCorrect, MAX_SIZE },
+  { "range", checkRange, MAX_SIZE },
+  { "spec", checkSpec, MAX_SIZED_SIZE },
+  { "hidden", checkHidden, MAX_SIZE },
+  { "wide", checkWide, MAX_SIZED_SIZE },
+  { "streamed", checkStreamed, MAX_SIZED_SIZE }
+};
+
+// Price a batch of random states of a mix of games, the standard one
+// with decks of up to MAX_BATCH_SIZE cards and variants of up to
+// MAX_SPEC_SIZE, and return the number of jobs which disagree with
+// the engines which price them one at a time.
+static int checkBatch(void) {
+  struct gameSpec specs[] = {
+    { MAX_BATCH_SIZE, DEALER_POLICY_STANDARD, TIE_RULE_HIGHER, OUTCOME_STREAK },
+    { MAX_SPEC_SIZE, DEALER_POLICY_STANDARD, TIE_RULE_HIGHER, OUTCOME_TOTAL },
+    { MAX_SPEC_SIZE, DEALER_POLICY_CONTRARIAN, TIE_RULE_LOWER, OUTCOME_TOTAL },
+    { MAX_SPEC_SIZE, DEALER_POLICY_ALWAYS_HIGHER, TIE_RULE_HIGHER, OUTCOME_STREAK }
+  };
+  int numberGames = sizeof(specs) / sizeof(struct gameSpec);
+  struct compiledGame* games[sizeof(specs) / sizeof(struct gameSpec)];
+  struct pricingJob* jobs = calloc(NUMBER_BATCH_JOBS, sizeof(struct pricingJob));
+  struct workPool* pool = createWorkPool(getNumberProcessors());
+  double* probabilities = calloc(MAX_BATCH_SIZE, sizeof(double));
+  unsigned long int specNumerators[MAX_SPEC_SIZE];
+  unsigned long int specDenominators[MAX_SPEC_SIZE];
+  struct randomState random;
+  int numberDisagreeing = 0;
+
+  seedRandom(&random, SEED);
+
+  for (int i = 0; i < numberGames; i++) {
+    games[i] = compileGame(&specs[i]);
+  }
+
+  // One job in a hundred is of a large deck of the standard game.
+  for (int i = 0; i < NUMBER_BATCH_JOBS; i++) {
+    struct pricingJob* job = &jobs[i];
+    int large = nextRandomBelow(&random, 100) == 0;
+
+    job->game = large ? games[0] : games[nextRandomBelow(&random, numberGames)];
+    job->size = 2 + nextRandomBelow(&random, (large ? MAX_BATCH_SIZE : MAX_SPEC_SIZE) - 1);
+    job->numberLower = nextRandomBelow(&random, job->size + 1);
+    job->probabilities = calloc(getLengthOfProbabilities(job->size), sizeof(double));
+  }
+
+  priceBatch(pool, jobs, NUMBER_BATCH_JOBS);
+
+  for (int i = 0; i < NUMBER_BATCH_JOBS; i++) {
+    struct pricingJob* job = &jobs[i];
+    int exact = job->size <= MAX_SPEC_SIZE;
+
+    if (exact) {
+      calculateSpecProbabilities(job->game, specNumerators, specDenominators, job->size, job->numberLower);
+    } else {
+      calculateStreamedProbabilities(probabilities, job->size, job->numberLower);
+    }
+
+    // Totals sum rows in which probabilities cancel, so their smallest
+    // outcomes are only accurate to within DBL_EPSILON of the largest.
+    double floor = job->game->spec.outcomeKind == OUTCOME_TOTAL ? DBL_EPSILON : DBL_MIN;
+
+    for (int n = 0; n < getLengthOfProbabilities(job->size); n++) {
+      double reference = exact ? (double) specNumerators[n] / specDenominators[n] : probabilities[n];
+
+      if (!agreesWithin(job->probabilities[n], reference, floor)) {
+        numberDisagreeing++;
+        break;
+      }
+    }
+
+    free(job->probabilities);
+  }
+
+  for (int i = 0; i < numberGames; i++) {
+    freeCompiledGame(games[i]);
+  }
+
+  freeWorkPool(pool);
+  free(probabilities);
+  free(jobs);
+
+  return numberDisagreeing;
+}
+
+struct replicaReader {
+  struct replicatedTable* replicated;
+  int node;
+  atomic_int* updating;
+  long numberTorn;
+};
+
+// Every table a reader acquires must have every probability equal to
+// the first, as every update fills its table with one value, and no
+// older value than one already seen on its node.
+static void* readReplicas(void* argument) {
+  struct replicaReader* reader = argument;
+  double lastValue = 0;
+
+  pinToNode(reader->replicated->topology, reader->node);
+
+  while (atomic_load(reader->updating)) {
+    int ticket;
+    struct outcomeTable* table = acquireReplica(reader->replicated, reader->node, &ticket);
+    int numberValues = getNumberOutcomeValues(table);
+    double value = table->probabilities[0];
+
+    for (int i = 1; i < numberValues; i++) {
+      if (table->probabilities[i] != value) {
+        reader->numberTorn++;
+        break;
+      }
+    }
+
+    reader->numberTorn += value < lastValue;
+    lastValue = value;
+    releaseReplica(reader->replicated, reader->node, ticket);
+  }
+
+  return NULL;
+}
+
+static void fillOutcomeTable(struct outcomeTable* table, double value) {
+  for (int i = 0; i < getNumberOutcomeValues(table); i++) {
+    table->probabilities[i] = value;
+  }
+}
+
+// Update a table replicated on a fake topology, with every node on all
+// of the processors, NUMBER_UPDATES times under the readers, and
+// return the number of acquired tables which were not intact.
+static int checkReplicas(void) {
+  int numberCpus = getNumberProcessors();
+  struct numaTopology topology = { NUMBER_FAKE_NODES, NULL, NULL };
+  struct outcomeTable* table = createOutcomeTable(MAX_SIZE);
+  struct replicaReader readers[NUMBER_FAKE_NODES * READERS_PER_NODE];
+  pthread_t threads[NUMBER_FAKE_NODES * READERS_PER_NODE];
+  atomic_int updating;
+  int numberTorn = 0;
+
+  topology.cpuOffsets = calloc(NUMBER_FAKE_NODES + 1, sizeof(int));
+  topology.cpus = calloc(NUMBER_FAKE_NODES * numberCpus, sizeof(int));
+
+  for (int node = 0; node < NUMBER_FAKE_NODES; node++) {
+    topology.cpuOffsets[node + 1] = (node + 1) * numberCpus;
+
+    for (int cpu = 0; cpu < numberCpus; cpu++) {
+      topology.cpus[node * numberCpus + cpu] = cpu;
+    }
+  }
+
+  fillOutcomeTable(table, 0);
+
+  struct replicatedTable* replicated = createReplicatedTable(&topology, table);
+
+  atomic_init(&updating, 1);
+
+  for (int i = 0; i < NUMBER_FAKE_NODES * READERS_PER_NODE; i++) {
+    readers[i] = (struct replicaReader) { replicated, i % NUMBER_FAKE_NODES, &updating, 0 };
+    pthread_create(&threads[i], NULL, readReplicas, &readers[i]);
+  }
+
+  for (int update = 1; update <= NUMBER_UPDATES; update++) {
+    fillOutcomeTable(table, update);
+    updateReplicatedTable(replicated, table);
+  }
+
+  atomic_store(&updating, 0);
+
+  for (int i = 0; i < NUMBER_FAKE_NODES * READERS_PER_NODE; i++) {
+    pthread_join(threads[i], NULL);
+    numberTorn += readers[i].numberTorn;
+  }
+
+  numberTorn += getReplicatedTableVersion(replicated) != NUMBER_UPDATES;
+
+  freeReplicatedTable(replicated);
+  freeOutcomeTable(table);
+  free(topology.cpuOffsets);
+  free(topology.cpus);
+
+  return numberTorn;
+}
+
+static void printCheck(const char* name, int numberDisagreeing, const char* items) {
+  printf("%-12s %s (%d %s disagree)\n", name, numberDisagreeing == 0 ? "ok" : "FAILED", numberDisagreeing, items);
+}
+
+int main(void) {
+  int numberChecks = sizeof(checks) / sizeof(struct check);
+  int numberFailed = 0;
+  int numberDisagreeing[sizeof(checks) / sizeof(struct check)] = { 0 };
+
+  struct gameSpec standardSpec = { MAX_SIZED_SIZE, DEALER_POLICY_STANDARD, TIE_RULE_HIGHER, OUTCOME_STREAK };
+
+  correctTable = createCorrectTable(MAX_SIZE);
+  rangeTable = createRangeTable(MAX_SIZE);
+  standardGame = compileGame(&standardSpec);
+  standardWorkspace = createSpecWorkspace(MAX_SIZED_SIZE, OUTCOME_STREAK);
+  outcomeTable = createOutcomeTable(MAX_SIZE);
+
+  for (int size = 2; size <= MAX_SIZED_SIZE; size++) {
+    for (int numberLower = 0; numberLower <= size; numberLower++) {
+      if (size <= MAX_SIZE) {
+        calculateProbabilities(numerators, denominators, size, numberLower);
+      } else {
+        calculateSizedProbabilities(numerators, denominators, size, numberLower);
+      }
+
+      for (int i = 0; i < numberChecks; i++) {
+        if (size <= checks[i].maxSize) {
+          numberDisagreeing[i] += !checks[i].agrees(size, numberLower);
+        }
+      }
+    }
+  }
+
+  for (int i = 0; i < numberChecks; i++) {
+    printCheck(checks[i].name, numberDisagreeing[i], "states");
+    numberFailed += numberDisagreeing[i] > 0;
+  }
+
+  int numberBatchDisagreeing = checkBatch();
+
+  printCheck("batch", numberBatchDisagreeing, "jobs");
+  numberFailed += numberBatchDisagreeing > 0;
+
+  int numberTorn = checkReplicas();
+
+  printCheck("replicas", numberTorn, "tables");
+  numberFailed += numberTorn > 0;
+
+  freeCorrectTable(correctTable);
+  freeRangeTable(rangeTable);
+  freeCompiledGame(standardGame);
+  freeSpecWorkspace(standardWorkspace);
+  freeOutcomeTable(outcomeTable);
+
+  return numberFailed > 0;
+}
@@ -0,0 +1,121 @@
+#include <stdlib.h>
+#include "state.h"
+#include "correct.h"
+
+// This is the same characterisation of the game state as in prob.c,
+// with the number of correct predictions so far added to it. Let
+// counts[size][numberLower][c] be the number of ways to deal the next
+// (size - 1) cards from the state (size, numberLower) with exactly c
+// of the deals predicted correctly. With one card left there is
+// nothing to deal, so counts[1][numberLower][0] = 1.
+//
+// Otherwise the next card leads to one of the states (size - 1, j),
+// and is predicted correctly or not. If it is, the following deals
+// must have (c - 1) correct predictions, and c otherwise, so
+//
+// counts[size][numberLower][c] = sum over correct j of counts[size - 1][j][c - 1]
+//                              + sum over the other j of counts[size - 1][j][c].
+//
+// As in state.c, the correct deals form a single range of j, so both
+// sums are differences of prefix sums over j, taken for each c. The
+// table is filled from the smallest decks up, and takes O(size^3)
+// time and space in all.
+
+static int getNumberCounts(int size) {
+  return size;
+}
+
+static int* createSizeOffsets(int maxSize) {
+  int* sizeOffsets = calloc(maxSize + 2, sizeof(int));
+
+  for (int size = 0; size <= maxSize; size++) {
+    sizeOffsets[size + 1] = sizeOffsets[size] + (size + 1) * getNumberCounts(size);
+  }
+
+  return sizeOffsets;
+}
+
+unsigned long int* getCorrectCounts(struct correctTable* table, int size, int numberLower) {
+  return table->counts + table->sizeOffsets[size] + numberLower * getNumberCounts(size);
+}
+
+double getCorrectProbability(struct correctTable* table, int size, int numberLower, int numberCorrect) {
+  double numberShuffles = 1;
+
+  for (int i = 2; i <= size; i++) {
+    numberShuffles *= i;
+  }
+
+  return getCorrectCounts(table, size, numberLower)[numberCorrect] / numberShuffles;
+}
+
+static void calculateCorrectTable(struct correctTable* table) {
+  int maxSize = table->maxSize;
+
+  // prefixSums[c * (maxSize + 1) + j] is the sum of the counts of c
+  // correct predictions over the states below j.
+  unsigned long int* prefixSums = calloc(maxSize * (maxSize + 1), sizeof(unsigned long int));
+
+  for (int numberLower = 0; numberLower <= 1 && numberLower <= maxSize; numberLower++) {
+    getCorrectCounts(table, 1, numberLower)[0] = 1;
+  }
+
+  for (int size = 2; size <= maxSize; size++) {
+    int smallerSize = size - 1;
+
+    for (int c = 0; c < smallerSize; c++) {
+      unsigned long int* sums = &prefixSums[c * (maxSize + 1)];
+
+      for (int j = 0; j <= smallerSize; j++) {
+        sums[j + 1] = sums[j] + getCorrectCounts(table, smallerSize, j)[c];
+      }
+    }
+
+    for (int numberLower = 0; numberLower <= size; numberLower++) {
+      unsigned long int* counts = getCorrectCounts(table, size, numberLower);
+      int higher = predictsHigher(size, numberLower);
+
+      // The correct deals are to j in [start, end).
+      int start = higher ? numberLower : 0;
+      int end = higher ? size : numberLower;
+
+      for (int c = 0; c < size; c++) {
+        unsigned long int count = 0;
+
+        if (c > 0) {
+          unsigned long int* sums = &prefixSums[(c - 1) * (maxSize + 1)];
+
+          count += sums[end] - sums[start];
+        }
+
+        if (c < smallerSize) {
+          unsigned long int* sums = &prefixSums[c * (maxSize + 1)];
+
+          count += sums[start] + (sums[size] - sums[end]);
+        }
+
+        counts[c] = count;
+      }
+    }
+  }
+
+  free(prefixSums);
+}
+
+struct correctTable* createCorrectTable(int maxSize) {
+  struct correctTable* table = malloc(sizeof(struct correctTable));
+
+  table->maxSize = maxSize;
+  table->sizeOffsets = createSizeOffsets(maxSize);
+  table->counts = calloc(table->sizeOffsets[maxSize + 1], sizeof(unsigned long int));
+
+  calculateCorrectTable(table);
+
+  return table;
+}
+
+void freeCorrectTable(struct correctTable* table) {
+  free(table->sizeOffsets);
+  free(table->counts);
+  free(table);
+}
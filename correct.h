@@ -0,0 +1,29 @@
+// The game carries on after the computer's first wrong prediction, so
+// the total number of correct predictions over the rest of the game
+// can be bet on too. This is the exact distribution of that total for
+// every state with a `size` of at most `maxSize`, over the same
+// getLengthOfProbabilities(size) deals as the outcomes in prob.c. The
+// very last card is always predicted correctly, and is not counted.
+//
+// The counts are of the ways to deal the rest of the deck, out of
+// `size`! ways, which fit in 64 bits for decks of up to 20 cards.
+#define MAX_CORRECT_SIZE 20
+
+struct correctTable {
+  int maxSize;
+  int* sizeOffsets;
+  unsigned long int* counts;
+};
+
+struct correctTable* createCorrectTable(int maxSize);
+
+void freeCorrectTable(struct correctTable* table);
+
+// A pointer to the `size` counts of the state (size, numberLower), of
+// the ways to deal the rest of the deck with 0, 1, ..., (size - 1)
+// correct predictions.
+unsigned long int* getCorrectCounts(struct correctTable* table, int size, int numberLower);
+
+// The probability of exactly `numberCorrect` correct predictions from
+// the state (size, numberLower).
+double getCorrectProbability(struct correctTable* table, int size, int numberLower, int numberCorrect);
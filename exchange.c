@@ -0,0 +1,439 @@
+#include <stdlib.h>
+#include <math.h>
+#include "prob.h"
+#include "odds.h"
+#include "rng.h"
+#include "state.h"
+#include "book.h"
+#include "exchange.h"
+
+// There is one book for each outcome of the starting state (see
+// prob.c). The outcome at index n is open while fewer than (n + 1)
+// deals have been predicted correctly, and its fair probability is
+// then the outcome at index (n - streak) of the current state. When an
+// outcome is settled, its book is cleared.
+//
+// Agents learn of a deal only after their latency, and act on the game
+// state as it was at that deal, even if the next card has been dealt
+// in the meantime. Their orders rest in the books at stale odds until
+// they quote again, which is where latency costs a maker money.
+//
+// Each matched bet is kept as two amounts for each of its agents: the
+// profit if the outcome is won, and the profit if it is lost. If the
+// outcome is won, the backer gains the stake times (odds - 1), and the
+// layer loses as much. If it is lost, the layer gains the stake, and
+// the backer loses it. Commission is taken off the gains at the rate
+// of the agent gaining. Once the outcome is settled, the amount for
+// its result is added to each agent's profit.
+//
+// The simulation is driven by a binary heap of events ordered by time,
+// and then by the order in which they were scheduled.
+
+#define EVENT_DEAL 0
+#define EVENT_REACT 1
+#define EVENT_NOISE 2
+
+#define ORDERS_PER_OUTCOME 2
+
+struct event {
+  long time;
+  long sequence;
+  int type;
+  int agent;
+  // The game state an agent reacts to.
+  long game;
+  int size;
+  int numberLower;
+  int streak;
+};
+
+struct eventQueue {
+  struct event* events;
+  int length;
+  int capacity;
+  long sequence;
+};
+
+struct exchange {
+  struct exchangeParameters* parameters;
+  struct agentConfig* agents;
+  int numberAgents;
+  struct agentResult* results;
+  struct outcomeTable* table;
+  struct matchingEngine* engine;
+  struct eventQueue queue;
+  struct randomState random;
+  int numberOutcomes;
+  // For each agent and outcome, the profit if the outcome is won, and
+  // if it is lost, and the identifiers of the agent's resting orders.
+  double* wonProfits;
+  double* lostProfits;
+  long* orders;
+  long game;
+  int size;
+  int numberLower;
+  int streak;
+  int over;
+  long numberEvents;
+};
+
+static int isEarlier(struct event* a, struct event* b) {
+  return a->time < b->time || (a->time == b->time && a->sequence < b->sequence);
+}
+
+static void pushEvent(struct eventQueue* queue, struct event event) {
+  if (queue->length == queue->capacity) {
+    queue->capacity = queue->capacity > 0 ? 2 * queue->capacity : 64;
+    queue->events = realloc(queue->events, queue->capacity * sizeof(struct event));
+  }
+
+  event.sequence = queue->sequence++;
+
+  int i = queue->length++;
+
+  while (i > 0 && isEarlier(&event, &queue->events[(i - 1) / 2])) {
+    queue->events[i] = queue->events[(i - 1) / 2];
+    i = (i - 1) / 2;
+  }
+
+  queue->events[i] = event;
+}
+
+static struct event popEvent(struct eventQueue* queue) {
+  struct event first = queue->events[0];
+  struct event last = queue->events[--queue->length];
+  int i = 0;
+
+  for (;;) {
+    int child = 2 * i + 1;
+
+    if (child >= queue->length) {
+      break;
+    }
+
+    if (child + 1 < queue->length && isEarlier(&queue->events[child + 1], &queue->events[child])) {
+      child++;
+    }
+
+    if (!isEarlier(&queue->events[child], &last)) {
+      break;
+    }
+
+    queue->events[i] = queue->events[child];
+    i = child;
+  }
+
+  if (queue->length > 0) {
+    queue->events[i] = last;
+  }
+
+  return first;
+}
+
+// Record a match in the positions of both agents.
+static void recordMatch(void* context, int book, int backAgent, int layAgent, int ticks, int stake) {
+  struct exchange* exchange = context;
+  double winnings = stake * ((double) ticks / TICKS_IN_UNIT - 1);
+  int back = backAgent * exchange->numberOutcomes + book;
+  int lay = layAgent * exchange->numberOutcomes + book;
+
+  exchange->wonProfits[back] += winnings * (1 - exchange->agents[backAgent].commission);
+  exchange->lostProfits[back] -= stake;
+  exchange->wonProfits[lay] -= winnings;
+  exchange->lostProfits[lay] += stake * (1 - exchange->agents[layAgent].commission);
+  exchange->results[backAgent].matchedStake += stake;
+  exchange->results[layAgent].matchedStake += stake;
+}
+
+static void settleOutcome(struct exchange* exchange, int outcome, int won) {
+  for (int agent = 0; agent < exchange->numberAgents; agent++) {
+    int index = agent * exchange->numberOutcomes + outcome;
+
+    exchange->results[agent].profit += won ? exchange->wonProfits[index] : exchange->lostProfits[index];
+    exchange->wonProfits[index] = 0;
+    exchange->lostProfits[index] = 0;
+  }
+
+  clearBook(exchange->engine, outcome);
+}
+
+// The fair probability of an open outcome in the given state.
+static double getFairProbability(struct exchange* exchange, int size, int numberLower, int streak, int outcome) {
+  return getOutcomeProbabilities(exchange->table, size, numberLower)[outcome - streak];
+}
+
+// Schedule every maker and sniper to react to the current state.
+static void scheduleReactions(struct exchange* exchange, long time) {
+  for (int agent = 0; agent < exchange->numberAgents; agent++) {
+    if (exchange->agents[agent].kind == AGENT_NOISE) {
+      continue;
+    }
+
+    struct event event = {
+      time + exchange->agents[agent].latency,
+      0,
+      EVENT_REACT,
+      agent,
+      exchange->game,
+      exchange->size,
+      exchange->numberLower,
+      exchange->streak
+    };
+
+    pushEvent(&exchange->queue, event);
+  }
+}
+
+static void scheduleDeal(struct exchange* exchange, long time) {
+  struct event event = { time + exchange->parameters->dealInterval, 0, EVENT_DEAL, -1, 0, 0, 0, 0 };
+
+  pushEvent(&exchange->queue, event);
+}
+
+static void startGame(struct exchange* exchange, long time) {
+  exchange->game++;
+  exchange->size = exchange->parameters->size;
+  exchange->numberLower = exchange->parameters->numberLower;
+  exchange->streak = 0;
+  exchange->over = 0;
+
+  scheduleReactions(exchange, time);
+  scheduleDeal(exchange, time);
+}
+
+// Deal the next card, and settle the outcomes which it decides.
+static void deal(struct exchange* exchange, long time) {
+  int position = nextRandomBelow(&exchange->random, exchange->size);
+  int correct = isCorrectPrediction(exchange->size, exchange->numberLower, position);
+
+  exchange->size--;
+  exchange->numberLower = position;
+
+  if (correct) {
+    settleOutcome(exchange, exchange->streak, 1);
+    exchange->streak++;
+  } else {
+    for (int outcome = exchange->streak; outcome < exchange->numberOutcomes; outcome++) {
+      settleOutcome(exchange, outcome, 0);
+    }
+  }
+
+  if (!correct || exchange->streak == exchange->numberOutcomes) {
+    exchange->over = 1;
+  } else {
+    scheduleReactions(exchange, time);
+    scheduleDeal(exchange, time);
+  }
+}
+
+static void quote(struct exchange* exchange, int agent, struct event* event) {
+  struct agentConfig* config = &exchange->agents[agent];
+  long* orders = &exchange->orders[agent * exchange->numberOutcomes * ORDERS_PER_OUTCOME];
+
+  for (int outcome = exchange->streak; outcome < exchange->numberOutcomes; outcome++) {
+    double probability = getFairProbability(exchange, event->size, event->numberLower, event->streak, outcome);
+
+    cancelOrder(exchange->engine, orders[outcome * ORDERS_PER_OUTCOME + SIDE_BACK]);
+    cancelOrder(exchange->engine, orders[outcome * ORDERS_PER_OUTCOME + SIDE_LAY]);
+    orders[outcome * ORDERS_PER_OUTCOME + SIDE_BACK] = -1;
+    orders[outcome * ORDERS_PER_OUTCOME + SIDE_LAY] = -1;
+
+    if (probability <= 0 || probability >= 1) {
+      continue;
+    }
+
+    int backTicks = calculateTightestBackTicks(probability, config->commission);
+    int layTicks = calculateTightestLayTicks(probability, config->commission);
+
+    // A side with no profitable odds on the ladder, or none once moved
+    // wider, is not quoted. The books stop short of the ladder at
+    // BOOK_MAX_TICKS: a back quote above it would only lose money at
+    // any odds the book holds, so it is rejected, while a lay quote
+    // above it is still profitable when moved down to the top of the
+    // book.
+    if (backTicks != NO_ODDS_TICKS && backTicks + config->offsetTicks <= MAX_ODDS_TICKS) {
+      if (backTicks + config->offsetTicks > BOOK_MAX_TICKS) {
+        exchange->results[agent].ordersRejected++;
+      } else {
+        orders[outcome * ORDERS_PER_OUTCOME + SIDE_BACK] =
+          submitOrder(exchange->engine, outcome, agent, SIDE_BACK, backTicks + config->offsetTicks, config->stake);
+        exchange->results[agent].ordersSent++;
+      }
+    }
+
+    layTicks -= config->offsetTicks;
+
+    if (layTicks > BOOK_MAX_TICKS) {
+      layTicks = BOOK_MAX_TICKS;
+    }
+
+    if (layTicks >= MIN_ODDS_TICKS) {
+      orders[outcome * ORDERS_PER_OUTCOME + SIDE_LAY] =
+        submitOrder(exchange->engine, outcome, agent, SIDE_LAY, layTicks, config->stake);
+      exchange->results[agent].ordersSent++;
+    }
+  }
+}
+
+// Back any resting lay order at odds we would back at, and lay any
+// resting back order at odds we would lay at.
+static void snipe(struct exchange* exchange, int agent, struct event* event) {
+  struct agentConfig* config = &exchange->agents[agent];
+
+  for (int outcome = exchange->streak; outcome < exchange->numberOutcomes; outcome++) {
+    double probability = getFairProbability(exchange, event->size, event->numberLower, event->streak, outcome);
+
+    if (probability <= 0 || probability >= 1) {
+      continue;
+    }
+
+    int backTicks = calculateTightestBackTicks(probability, config->commission);
+    int layTicks = calculateTightestLayTicks(probability, config->commission);
+    int bestLay = getBestTicks(exchange->engine, outcome, SIDE_LAY);
+    int bestBack = getBestTicks(exchange->engine, outcome, SIDE_BACK);
+
+    if (backTicks != NO_ODDS_TICKS && bestLay != 0 && bestLay >= backTicks) {
+      submitImmediateOrder(exchange->engine, outcome, agent, SIDE_BACK, backTicks, config->stake);
+      exchange->results[agent].ordersSent++;
+    }
+
+    // Every resting back order is at or below BOOK_MAX_TICKS, so a lay
+    // above it takes the same orders from the top of the book.
+    if (layTicks != NO_ODDS_TICKS && bestBack != 0 && bestBack <= layTicks) {
+      submitImmediateOrder(exchange->engine, outcome, agent, SIDE_LAY,
+                           layTicks < BOOK_MAX_TICKS ? layTicks : BOOK_MAX_TICKS, config->stake);
+      exchange->results[agent].ordersSent++;
+    }
+  }
+}
+
+static void trade(struct exchange* exchange, int agent) {
+  struct agentConfig* config = &exchange->agents[agent];
+  int numberOpen = exchange->numberOutcomes - exchange->streak;
+  int outcome = exchange->streak + nextRandomBelow(&exchange->random, numberOpen);
+
+  if (nextRandomBelow(&exchange->random, 2) == 0) {
+    submitImmediateOrder(exchange->engine, outcome, agent, SIDE_BACK, MIN_ODDS_TICKS, config->stake);
+  } else {
+    submitImmediateOrder(exchange->engine, outcome, agent, SIDE_LAY, BOOK_MAX_TICKS, config->stake);
+  }
+
+  exchange->results[agent].ordersSent++;
+}
+
+static void scheduleNoise(struct exchange* exchange, int agent, long time) {
+  double wait = -log(1 - nextRandomDouble(&exchange->random)) / exchange->agents[agent].rate;
+  struct event event = { time + 1 + (long) (wait * 1e6), 0, EVENT_NOISE, agent, 0, 0, 0, 0 };
+
+  pushEvent(&exchange->queue, event);
+}
+
+static void handleEvent(struct exchange* exchange, struct event* event) {
+  if (event->type == EVENT_DEAL) {
+    deal(exchange, event->time);
+  } else if (event->type == EVENT_REACT) {
+    if (event->game == exchange->game && !exchange->over) {
+      if (exchange->agents[event->agent].kind == AGENT_MAKER) {
+        quote(exchange, event->agent, event);
+      } else {
+        snipe(exchange, event->agent, event);
+      }
+    }
+  } else {
+    if (!exchange->over) {
+      trade(exchange, event->agent);
+    }
+
+    scheduleNoise(exchange, event->agent, event->time);
+  }
+}
+
+static void initialiseExchange(struct exchange* exchange,
+                               struct exchangeParameters* parameters,
+                               struct agentConfig* agents,
+                               int numberAgents,
+                               struct agentResult* results) {
+  int numberOutcomes = getLengthOfProbabilities(parameters->size);
+  int numberPositions = numberAgents * numberOutcomes;
+
+  exchange->parameters = parameters;
+  exchange->agents = agents;
+  exchange->numberAgents = numberAgents;
+  exchange->results = results;
+  exchange->numberOutcomes = numberOutcomes;
+  exchange->table = createOutcomeTable(parameters->size);
+  exchange->engine = createMatchingEngine(numberOutcomes,
+                                          numberPositions * ORDERS_PER_OUTCOME,
+                                          recordMatch,
+                                          exchange);
+  exchange->queue.events = NULL;
+  exchange->queue.length = 0;
+  exchange->queue.capacity = 0;
+  exchange->queue.sequence = 0;
+  exchange->wonProfits = calloc(numberPositions, sizeof(double));
+  exchange->lostProfits = calloc(numberPositions, sizeof(double));
+  exchange->orders = malloc(numberPositions * ORDERS_PER_OUTCOME * sizeof(long));
+  exchange->game = 0;
+  exchange->numberEvents = 0;
+
+  for (int i = 0; i < numberPositions * ORDERS_PER_OUTCOME; i++) {
+    exchange->orders[i] = -1;
+  }
+
+  for (int agent = 0; agent < numberAgents; agent++) {
+    results[agent].profit = 0;
+    results[agent].matchedStake = 0;
+    results[agent].ordersSent = 0;
+    results[agent].ordersRejected = 0;
+  }
+
+  seedRandom(&exchange->random, parameters->seed);
+}
+
+static void clearExchange(struct exchange* exchange) {
+  freeOutcomeTable(exchange->table);
+  freeMatchingEngine(exchange->engine);
+  free(exchange->queue.events);
+  free(exchange->wonProfits);
+  free(exchange->lostProfits);
+  free(exchange->orders);
+}
+
+void simulateExchange(struct exchangeParameters* parameters,
+                      struct agentConfig* agents,
+                      int numberAgents,
+                      struct agentResult* results,
+                      struct exchangeStatistics* statistics) {
+  struct exchange exchange;
+
+  initialiseExchange(&exchange, parameters, agents, numberAgents, results);
+
+  for (int agent = 0; agent < numberAgents; agent++) {
+    if (agents[agent].kind == AGENT_NOISE) {
+      scheduleNoise(&exchange, agent, 0);
+    }
+  }
+
+  startGame(&exchange, 0);
+
+  while (exchange.queue.length > 0) {
+    struct event event = popEvent(&exchange.queue);
+
+    exchange.numberEvents++;
+    handleEvent(&exchange, &event);
+
+    if (exchange.over) {
+      if (exchange.game == parameters->numberGames) {
+        break;
+      }
+
+      startGame(&exchange, event.time);
+    }
+  }
+
+  statistics->numberOrders = exchange.engine->numberOrders;
+  statistics->numberMatches = exchange.engine->numberMatches;
+  statistics->numberEvents = exchange.numberEvents;
+
+  clearExchange(&exchange);
+}
@@ -0,0 +1,52 @@
+// An agent based simulation of the Exchange Hi Lo outcome markets, on
+// the matching engine in book.h. Games are dealt one after another,
+// and each agent reacts to every deal after its own latency, in
+// microseconds of simulated time.
+
+// Makers cancel their quotes and quote again to back and lay every
+// open outcome, `offsetTicks` wider than their tightest profitable
+// odds. Snipers take any resting order which is profitable for them
+// at the current probabilities. Noise traders take the best price on
+// a random outcome and side, `rate` times per second on average.
+#define AGENT_MAKER 0
+#define AGENT_SNIPER 1
+#define AGENT_NOISE 2
+
+struct agentConfig {
+  int kind;
+  double commission;
+  int latency;
+  int offsetTicks;
+  int stake;
+  double rate;
+};
+
+struct agentResult {
+  double profit;
+  long matchedStake;
+  long ordersSent;
+  // Orders to back at odds above BOOK_MAX_TICKS, which the books do
+  // not hold (see book.h), and so were not sent.
+  long ordersRejected;
+};
+
+struct exchangeParameters {
+  int size;
+  int numberLower;
+  // The simulated microseconds between deals.
+  int dealInterval;
+  int numberGames;
+  unsigned long seed;
+};
+
+struct exchangeStatistics {
+  long numberOrders;
+  long numberMatches;
+  long numberEvents;
+};
+
+void simulateExchange(struct exchangeParameters* parameters,
+                      struct agentConfig* agents,
+                      int numberAgents,
+                      struct agentResult* results,
+                      struct exchangeStatistics* statistics);
@@ -0,0 +1,53 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "exchange.h"
+
+// Simulate the exchange with a mix of makers on different commission
+// tiers and latencies, a sniper and noise traders, and print the
+// result of each agent. Run as `exchange [number_games]`.
+int main(int argc, char** argv) {
+  struct agentConfig agents[] = {
+    { AGENT_MAKER, 0.03, 1000, 0, 10, 0 },
+    { AGENT_MAKER, 0.03, 50000, 0, 10, 0 },
+    { AGENT_MAKER, 0.02, 1000, 1, 10, 0 },
+    { AGENT_MAKER, 0.01, 20000, 2, 10, 0 },
+    { AGENT_SNIPER, 0.01, 5000, 0, 10, 0 },
+    { AGENT_NOISE, 0.05, 0, 0, 2, 200 },
+    { AGENT_NOISE, 0.05, 0, 0, 2, 200 }
+  };
+  int numberAgents = sizeof(agents) / sizeof(struct agentConfig);
+  struct exchangeParameters parameters = { 13, 0, 1000000, 10000, 0x48694c6f };
+  struct agentResult results[sizeof(agents) / sizeof(struct agentConfig)];
+  struct exchangeStatistics statistics;
+
+  if (argc > 1) {
+    parameters.numberGames = atoi(argv[1]);
+  }
+
+  clock_t start = clock();
+
+  simulateExchange(&parameters, agents, numberAgents, results, &statistics);
+
+  double seconds = (double) (clock() - start) / CLOCKS_PER_SEC;
+
+  for (int agent = 0; agent < numberAgents; agent++) {
+    printf("K: %d -- C: %.3f -- T: %6d -- P: %+12.2f -- M: %9ld -- O: %9ld -- R: %7ld\n",
+           agents[agent].kind,
+           agents[agent].commission,
+           agents[agent].latency,
+           results[agent].profit,
+           results[agent].matchedStake,
+           results[agent].ordersSent,
+           results[agent].ordersRejected);
+  }
+
+  printf("%ld orders, %ld matches, %ld events in %.3fs (%.0f orders per second)\n",
+         statistics.numberOrders,
+         statistics.numberMatches,
+         statistics.numberEvents,
+         seconds,
+         statistics.numberOrders / seconds);
+
+  return 0;
+}
@@ -0,0 +1,96 @@
+#include "prob.h"
+#include "state.h"
+#include "hidden.h"
+
+// The burned cards are a uniformly random subset of the remaining
+// cards, so, seen from anyone who does not know which they are, the
+// next card dealt is uniformly random among the unseen cards. If the
+// computer does not know the burned cards either, it predicts from
+// the unseen cards, and the game seen by the player is exactly the
+// standard game in the state (size, numberLower), stopped after
+// (size - numberHidden) deals. The outcomes are those of the standard
+// game, cut short.
+//
+// If the computer knows the burned cards, it plays the standard game
+// on the cards still to be dealt. Given that b of the burned cards are
+// lower than the last card, that is the state
+// (size - numberHidden, numberLower - b). The player only knows that b
+// is hypergeometric: the number of lower cards in a uniformly random
+// draw of `numberHidden` of the `size` cards, `numberLower` of which
+// are lower. Each outcome is then a mixture of the outcomes of at most
+// (numberHidden + 1) standard states, so pricing takes time
+// proportional to the number of outcomes times (numberHidden + 1).
+//
+// In both cases the player's only information about the burned cards
+// is their number. Once the computer has made a prediction knowing
+// them, its predictions tell the player something about them, which is
+// not taken into account.
+
+int getLengthOfHiddenProbabilities(int size, int numberHidden) {
+  return numberHidden == 0 ? getLengthOfProbabilities(size) : size - numberHidden;
+}
+
+static double getBinomialCoefficient(int n, int k) {
+  double coefficient = 1;
+
+  for (int i = 1; i <= k; i++) {
+    coefficient = coefficient * (n - k + i) / i;
+  }
+
+  return coefficient;
+}
+
+// The outcome at index n from the standard state (size, numberLower),
+// for any n up to `size` - 1. The very last deal is always predicted
+// correctly, so the (size - 1) deals of a full game are all correct as
+// often as the (size - 2) before them.
+static double getKnownOutcome(struct outcomeTable* table, int size, int numberLower, int n) {
+  int length = getLengthOfProbabilities(size);
+
+  if (length <= 0) {
+    return 1;
+  }
+
+  return getOutcomeProbabilities(table, size, numberLower)[n < length ? n : length - 1];
+}
+
+void calculateHiddenProbabilities(struct outcomeTable* table,
+                                  double* probabilitiesResult,
+                                  int size,
+                                  int numberLower,
+                                  int numberHidden,
+                                  int dealerSees) {
+  int length = getLengthOfHiddenProbabilities(size, numberHidden);
+
+  if (!dealerSees || numberHidden == 0) {
+    double* outcomes = getOutcomeProbabilities(table, size, numberLower);
+
+    for (int n = 0; n < length; n++) {
+      probabilitiesResult[n] = outcomes[n];
+    }
+
+    return;
+  }
+
+  int numberHigher = size - numberLower;
+  int dealtSize = size - numberHidden;
+  double numberDraws = getBinomialCoefficient(size, numberHidden);
+
+  for (int n = 0; n < length; n++) {
+    probabilitiesResult[n] = 0;
+  }
+
+  for (int b = 0; b <= numberHidden && b <= numberLower; b++) {
+    if (numberHidden - b > numberHigher) {
+      continue;
+    }
+
+    double weight = getBinomialCoefficient(numberLower, b)
+      * getBinomialCoefficient(numberHigher, numberHidden - b)
+      / numberDraws;
+
+    for (int n = 0; n < length; n++) {
+      probabilitiesResult[n] += weight * getKnownOutcome(table, dealtSize, numberLower - b, n);
+    }
+  }
+}
@@ -0,0 +1,23 @@
+// Pricing variants in which `numberHidden` of the `size` remaining
+// cards are burned face down, so that the player knows how many cards
+// are missing but not which. Only the other (size - numberHidden)
+// cards are dealt. `numberLower` counts all the remaining cards lower
+// than the last card, burned or not.
+//
+// If `dealerSees` is 0, the computer predicts from the cards it has
+// not seen, like the player. Otherwise it knows which cards were
+// burned, and predicts from the cards still to be dealt.
+
+// The number of outcomes, of the form "the next (n + 1) deals are
+// predicted correctly". With no cards hidden, this is the same as
+// getLengthOfProbabilities(size). Otherwise every deal is uncertain.
+int getLengthOfHiddenProbabilities(int size, int numberHidden);
+
+// The probabilities of those outcomes, from the outcome table of the
+// standard game (see state.h), which must cover `size`.
+void calculateHiddenProbabilities(struct outcomeTable* table,
+                                  double* probabilitiesResult,
+                                  int size,
+                                  int numberLower,
+                                  int numberHidden,
+                                  int dealerSees);
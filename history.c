@@ -0,0 +1,254 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "odds.h"
+#include "history.h"
+
+// The file starts with a header, followed by the blocks, which all
+// have the same length. Each block starts with its own header, and
+// then its columns one after another, each HISTORY_BLOCK_ROWS entries
+// long, so that every column starts on a 64 byte boundary.
+//
+// Storing each time relative to the first time of its block, in 32
+// bits, halves the widest column. A row whose time is too far from
+// the others in its block starts a new block instead. The other
+// columns are stored in the narrowest fixed width their values need,
+// rather than in a variable length encoding, so that a scan can find
+// any row of a column without decoding the rows before it.
+
+#define HISTORY_MAGIC "HILOHIST"
+#define HISTORY_VERSION 1
+
+struct historyHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t blockRows;
+  uint64_t numberRows;
+  uint32_t numberBlocks;
+  uint32_t maxSize;
+  char padding[32];
+};
+
+struct blockHeader {
+  int64_t firstTime;
+  int64_t lastTime;
+  uint64_t sizeMask;
+  uint32_t numberRows;
+  char padding[36];
+};
+
+#define TIMES_OFFSET sizeof(struct blockHeader)
+#define SIZES_OFFSET (TIMES_OFFSET + HISTORY_BLOCK_ROWS * sizeof(uint32_t))
+#define NUMBERS_LOWER_OFFSET (SIZES_OFFSET + HISTORY_BLOCK_ROWS)
+#define LAST_CORRECT_CARDS_OFFSET (NUMBERS_LOWER_OFFSET + HISTORY_BLOCK_ROWS)
+#define BACK_TICKS_OFFSET (LAST_CORRECT_CARDS_OFFSET + HISTORY_BLOCK_ROWS)
+#define LAY_TICKS_OFFSET (BACK_TICKS_OFFSET + HISTORY_BLOCK_ROWS * sizeof(uint32_t))
+#define MATCHED_STAKES_OFFSET (LAY_TICKS_OFFSET + HISTORY_BLOCK_ROWS * sizeof(uint32_t))
+#define BLOCK_LENGTH (MATCHED_STAKES_OFFSET + HISTORY_BLOCK_ROWS * sizeof(uint32_t))
+
+struct historyWriter {
+  FILE* file;
+  struct historyHeader header;
+  // The block being filled, laid out as in the file, apart from the
+  // times, which are kept in full until the block is written.
+  unsigned char* block;
+  int64_t* times;
+  int numberRows;
+};
+
+static struct blockHeader* getBlockHeader(unsigned char* block) {
+  return (struct blockHeader*) block;
+}
+
+struct historyWriter* createHistoryWriter(const char* path) {
+  FILE* file = fopen(path, "wb");
+
+  if (file == NULL) {
+    return NULL;
+  }
+
+  struct historyWriter* writer = calloc(1, sizeof(struct historyWriter));
+
+  writer->file = file;
+  memcpy(writer->header.magic, HISTORY_MAGIC, sizeof(writer->header.magic));
+  writer->header.version = HISTORY_VERSION;
+  writer->header.blockRows = HISTORY_BLOCK_ROWS;
+  writer->block = calloc(BLOCK_LENGTH, 1);
+  writer->times = calloc(HISTORY_BLOCK_ROWS, sizeof(int64_t));
+
+  // The header is written again with the final counts on closing.
+  if (fwrite(&writer->header, sizeof(writer->header), 1, file) != 1) {
+    fclose(file);
+    free(writer->block);
+    free(writer->times);
+    free(writer);
+
+    return NULL;
+  }
+
+  return writer;
+}
+
+static int writeBlock(struct historyWriter* writer) {
+  if (writer->numberRows == 0) {
+    return 1;
+  }
+
+  struct blockHeader* header = getBlockHeader(writer->block);
+  uint32_t* times = (uint32_t*) (writer->block + TIMES_OFFSET);
+
+  header->numberRows = writer->numberRows;
+
+  for (int row = 0; row < writer->numberRows; row++) {
+    times[row] = writer->times[row] - header->firstTime;
+  }
+
+  if (fwrite(writer->block, BLOCK_LENGTH, 1, writer->file) != 1) {
+    return 0;
+  }
+
+  writer->header.numberBlocks++;
+  writer->numberRows = 0;
+  memset(writer->block, 0, BLOCK_LENGTH);
+
+  return 1;
+}
+
+int appendHistoryRow(struct historyWriter* writer, struct historyRow* row) {
+  if (row->size < 0 || row->size > UINT8_MAX
+      || row->numberLower < 0 || row->numberLower > row->size
+      || row->lastCorrectCard < 0 || row->lastCorrectCard > UINT8_MAX
+      || row->backTicks < 0 || row->backTicks > MAX_ODDS_TICKS
+      || row->layTicks < 0 || row->layTicks > MAX_ODDS_TICKS
+      || row->matchedStake < 0) {
+    return 0;
+  }
+
+  struct blockHeader* header = getBlockHeader(writer->block);
+
+  if (writer->numberRows > 0) {
+    int64_t firstTime = row->time < header->firstTime ? row->time : header->firstTime;
+    int64_t lastTime = row->time > header->lastTime ? row->time : header->lastTime;
+
+    if ((uint64_t) (lastTime - firstTime) > UINT32_MAX && !writeBlock(writer)) {
+      return 0;
+    }
+  }
+
+  int index = writer->numberRows;
+
+  if (index == 0 || row->time < header->firstTime) {
+    header->firstTime = row->time;
+  }
+
+  if (index == 0 || row->time > header->lastTime) {
+    header->lastTime = row->time;
+  }
+
+  header->sizeMask |= 1ULL << (row->size < 63 ? row->size : 63);
+  writer->times[index] = row->time;
+  writer->block[SIZES_OFFSET + index] = row->size;
+  writer->block[NUMBERS_LOWER_OFFSET + index] = row->numberLower;
+  writer->block[LAST_CORRECT_CARDS_OFFSET + index] = row->lastCorrectCard;
+  ((uint32_t*) (writer->block + BACK_TICKS_OFFSET))[index] = row->backTicks;
+  ((uint32_t*) (writer->block + LAY_TICKS_OFFSET))[index] = row->layTicks;
+  ((uint32_t*) (writer->block + MATCHED_STAKES_OFFSET))[index] = row->matchedStake;
+
+  if ((uint32_t) row->size > writer->header.maxSize) {
+    writer->header.maxSize = row->size;
+  }
+
+  writer->header.numberRows++;
+  writer->numberRows++;
+
+  return writer->numberRows < HISTORY_BLOCK_ROWS || writeBlock(writer);
+}
+
+int closeHistoryWriter(struct historyWriter* writer) {
+  int success = writeBlock(writer)
+    && fseek(writer->file, 0, SEEK_SET) == 0
+    && fwrite(&writer->header, sizeof(writer->header), 1, writer->file) == 1;
+
+  success = fclose(writer->file) == 0 && success;
+  free(writer->block);
+  free(writer->times);
+  free(writer);
+
+  return success;
+}
+
+struct historyStore* openHistoryStore(const char* path) {
+  int descriptor = open(path, O_RDONLY);
+  struct stat status;
+
+  if (descriptor < 0) {
+    return NULL;
+  }
+
+  if (fstat(descriptor, &status) != 0 || (size_t) status.st_size < sizeof(struct historyHeader)) {
+    close(descriptor);
+
+    return NULL;
+  }
+
+  void* map = mmap(NULL, status.st_size, PROT_READ, MAP_SHARED, descriptor, 0);
+
+  if (map == MAP_FAILED) {
+    close(descriptor);
+
+    return NULL;
+  }
+
+  const struct historyHeader* header = map;
+
+  if (memcmp(header->magic, HISTORY_MAGIC, sizeof(header->magic)) != 0
+      || header->version != HISTORY_VERSION
+      || header->blockRows != HISTORY_BLOCK_ROWS
+      || (size_t) status.st_size < sizeof(struct historyHeader) + header->numberBlocks * BLOCK_LENGTH) {
+    munmap(map, status.st_size);
+    close(descriptor);
+
+    return NULL;
+  }
+
+  struct historyStore* store = malloc(sizeof(struct historyStore));
+
+  store->descriptor = descriptor;
+  store->map = map;
+  store->mapLength = status.st_size;
+  store->numberRows = header->numberRows;
+  store->numberBlocks = header->numberBlocks;
+  store->maxSize = header->maxSize;
+  store->blocks = calloc(header->numberBlocks, sizeof(struct historyBlock));
+
+  for (int i = 0; i < store->numberBlocks; i++) {
+    const unsigned char* block = store->map + sizeof(struct historyHeader) + i * BLOCK_LENGTH;
+    const struct blockHeader* blockHeader = (const struct blockHeader*) block;
+    struct historyBlock* columns = &store->blocks[i];
+
+    columns->firstTime = blockHeader->firstTime;
+    columns->lastTime = blockHeader->lastTime;
+    columns->sizeMask = blockHeader->sizeMask;
+    columns->numberRows = blockHeader->numberRows;
+    columns->times = (const uint32_t*) (block + TIMES_OFFSET);
+    columns->sizes = block + SIZES_OFFSET;
+    columns->numbersLower = block + NUMBERS_LOWER_OFFSET;
+    columns->lastCorrectCards = block + LAST_CORRECT_CARDS_OFFSET;
+    columns->backTicks = (const uint32_t*) (block + BACK_TICKS_OFFSET);
+    columns->layTicks = (const uint32_t*) (block + LAY_TICKS_OFFSET);
+    columns->matchedStakes = (const uint32_t*) (block + MATCHED_STAKES_OFFSET);
+  }
+
+  return store;
+}
+
+void closeHistoryStore(struct historyStore* store) {
+  munmap((void*) store->map, store->mapLength);
+  close(store->descriptor);
+  free(store->blocks);
+  free(store);
+}
@@ -0,0 +1,85 @@
+#include <stddef.h>
+#include <stdint.h>
+
+// A columnar store of recorded stages of games, for analysing how
+// games and markets played out. There is a row for every stage of
+// every recorded game, with the state of the deck at that stage, how
+// far the computer's predictions went in the game as a whole, and a
+// snapshot of the market on the next deal.
+//
+// Rows are kept in blocks of HISTORY_BLOCK_ROWS, each column of a
+// block stored contiguously in the narrowest width that holds it, so
+// that scans read only the columns they need and can test many rows
+// at once. Each block also keeps the range of its times and the set of
+// its deck sizes, so that scans skip blocks which cannot match.
+
+#define HISTORY_BLOCK_ROWS 16384
+
+struct historyRow {
+  // Seconds since the epoch at which the stage was dealt.
+  int64_t time;
+  int size;
+  int numberLower;
+  // The highest n such that the computer predicted correctly up to
+  // and including Card n in the game (see prob.c), or 0 if it failed
+  // on Card 1.
+  int lastCorrectCard;
+  // The tightest back and lay odds in ticks (see odds.h) on the next
+  // deal being predicted correctly when the stage was dealt, and the
+  // stake matched over the stage. Odds of 0 mark an empty side.
+  int backTicks;
+  int layTicks;
+  int matchedStake;
+};
+
+// The columns of one block, pointing into the mapped file. Times are
+// stored relative to `firstTime`. Every column has HISTORY_BLOCK_ROWS
+// entries, and the rows past `numberRows` are zero, with a size of 0,
+// so that scans can read rows in whole groups.
+struct historyBlock {
+  int64_t firstTime;
+  int64_t lastTime;
+  // Bit n is set if some row has a size of n, or of at least 63 for
+  // bit 63.
+  uint64_t sizeMask;
+  int numberRows;
+  const uint32_t* times;
+  const uint8_t* sizes;
+  const uint8_t* numbersLower;
+  const uint8_t* lastCorrectCards;
+  const uint32_t* backTicks;
+  const uint32_t* layTicks;
+  const uint32_t* matchedStakes;
+};
+
+struct historyWriter;
+
+// Create a store at `path`, replacing any file there. Return NULL if
+// it cannot be created.
+struct historyWriter* createHistoryWriter(const char* path);
+
+// Append a row. Sizes and cards must be at most 255, numbers lower at
+// most the size, odds at most MAX_ODDS_TICKS (see odds.h), and nothing
+// may be negative. Return 1 on success and 0 if the row does not fit
+// or the file cannot be written.
+int appendHistoryRow(struct historyWriter* writer, struct historyRow* row);
+
+// Write out the last block and close the store. Return 1 on success.
+int closeHistoryWriter(struct historyWriter* writer);
+
+struct historyStore {
+  int descriptor;
+  const unsigned char* map;
+  size_t mapLength;
+  long numberRows;
+  int numberBlocks;
+  // The largest size of any row.
+  int maxSize;
+  struct historyBlock* blocks;
+};
+
+// Map the store at `path` for reading. Return NULL if the file cannot
+// be opened or is not a store.
+struct historyStore* openHistoryStore(const char* path);
+
+void closeHistoryStore(struct historyStore* store);
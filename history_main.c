@@ -0,0 +1,181 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "odds.h"
+#include "pool.h"
+#include "rng.h"
+#include "state.h"
+#include "history.h"
+#include "scan.h"
+
+#define SIZE 13
+#define FIRST_TIME 1767225600
+#define GAME_INTERVAL 30
+#define STAGE_INTERVAL 2
+#define MARKET_COMMISSION 0.05
+
+// Record `numberGames` simulated games of SIZE cards into a store at
+// `path`, one row for each stage with outcomes open, as in
+// workload.c. The market on each stage is quoted as in
+// `modelMarketTicks` in odds.h, up to 3 ticks wider at random.
+static int recordGames(const char* path, long numberGames, struct outcomeTable* table) {
+  struct historyWriter* writer = createHistoryWriter(path);
+  struct historyRow rows[SIZE];
+  struct randomState random;
+
+  if (writer == NULL) {
+    return 0;
+  }
+
+  seedRandom(&random, 0x48694c6f);
+
+  for (long game = 0; game < numberGames; game++) {
+    int size = SIZE;
+    int numberLower = 0;
+    int numberRows = 0;
+    // Card 0 is dealt from the state (SIZE, 0), where any card is
+    // predicted correctly, and the last card is always predicted
+    // correctly, so a game which never fails is correct up to Card
+    // (SIZE - 1).
+    int card = 0;
+    int lastCorrectCard = SIZE - 1;
+
+    while (size >= 2) {
+      struct historyRow* row = &rows[numberRows++];
+      double probability = getOutcomeProbabilities(table, size, numberLower)[0];
+
+      row->time = FIRST_TIME + game * GAME_INTERVAL + card * STAGE_INTERVAL;
+      row->size = size;
+      row->numberLower = numberLower;
+      modelMarketTicks(probability,
+                       MARKET_COMMISSION,
+                       nextRandomBelow(&random, 4),
+                       &row->backTicks,
+                       &row->layTicks);
+      row->matchedStake = nextRandomBelow(&random, 1000);
+
+      int position = nextRandomBelow(&random, size);
+
+      if (!isCorrectPrediction(size, numberLower, position)) {
+        lastCorrectCard = card - 1;
+        break;
+      }
+
+      size--;
+      numberLower = position;
+      card++;
+    }
+
+    for (int i = 0; i < numberRows; i++) {
+      rows[i].lastCorrectCard = lastCorrectCard;
+
+      if (!appendHistoryRow(writer, &rows[i])) {
+        closeHistoryWriter(writer);
+
+        return 0;
+      }
+    }
+  }
+
+  return closeHistoryWriter(writer);
+}
+
+static double getSeconds(struct timespec* start) {
+  struct timespec end;
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  return (end.tv_sec - start->tv_sec) + (end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// Query a store of recorded games. Run as `history path
+// [number_games]`, which first records the given number of simulated
+// games into the store. Print how often Card 7 or further won from the
+// state 9/3 over the last quarter of the recorded period, against the
+// exact probability, and then how often it won from every state over
+// the whole period, with the average quoted odds.
+int main(int argc, char** argv) {
+  struct outcomeTable* table = createOutcomeTable(SIZE);
+
+  if (argc < 2) {
+    fprintf(stderr, "Usage: history path [number_games]\n");
+
+    return 1;
+  }
+
+  if (argc > 2 && !recordGames(argv[1], atol(argv[2]), table)) {
+    fprintf(stderr, "Cannot write %s\n", argv[1]);
+
+    return 1;
+  }
+
+  struct historyStore* store = openHistoryStore(argv[1]);
+
+  if (store == NULL || store->numberBlocks == 0) {
+    fprintf(stderr, "Cannot read %s\n", argv[1]);
+
+    return 1;
+  }
+
+  struct workPool* pool = createWorkPool(getNumberProcessors());
+  struct historyFilter filter;
+  struct historyAggregate total;
+  struct timespec start;
+  int64_t firstTime = store->blocks[0].firstTime;
+  int64_t lastTime = store->blocks[store->numberBlocks - 1].lastTime;
+
+  initialiseHistoryFilter(&filter);
+  filter.firstTime = lastTime - (lastTime - firstTime) / 4;
+  filter.minSize = filter.maxSize = 9;
+  filter.minNumberLower = filter.maxNumberLower = 3;
+  filter.winningCard = 7;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  scanHistory(pool, store, &filter, &total);
+
+  double seconds = getSeconds(&start);
+
+  // From a state of `size` cards, the next card dealt is Card
+  // (SIZE - size).
+  printf("Card 7 or further from 9/3, last quarter: %ld of %ld (%.4f, exact %.4f) in %.3fms\n",
+         total.numberWon,
+         total.numberRows,
+         total.numberRows > 0 ? (double) total.numberWon / total.numberRows : 0,
+         getOutcomeProbabilities(table, 9, 3)[7 - (SIZE - 9)],
+         seconds * 1000);
+
+  struct historyAggregate* groups = calloc(getNumberStates(store->maxSize), sizeof(struct historyAggregate));
+
+  initialiseHistoryFilter(&filter);
+  filter.winningCard = 7;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  groupHistoryByState(pool, store, &filter, groups);
+  seconds = getSeconds(&start);
+
+  for (int size = 2; size <= store->maxSize; size++) {
+    for (int numberLower = 0; numberLower <= size; numberLower++) {
+      struct historyAggregate* group = &groups[getStateIndex(size, numberLower)];
+
+      if (group->numberRows > 0) {
+        printf("S: %2d -- L: %2d -- N: %9ld -- W: %.4f -- B: %8.2f -- L: %8.2f -- M: %.1f\n",
+               size,
+               numberLower,
+               group->numberRows,
+               (double) group->numberWon / group->numberRows,
+               group->numberQuoted > 0 ? (double) group->backTicks / group->numberQuoted / TICKS_IN_UNIT : 0,
+               group->numberQuoted > 0 ? (double) group->layTicks / group->numberQuoted / TICKS_IN_UNIT : 0,
+               (double) group->matchedStake / group->numberRows);
+      }
+    }
+  }
+
+  printf("Grouped %ld rows in %.3fms\n", store->numberRows, seconds * 1000);
+
+  free(groups);
+  freeWorkPool(pool);
+  closeHistoryStore(store);
+  freeOutcomeTable(table);
+
+  return 0;
+}
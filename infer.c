@@ -0,0 +1,194 @@
+#include <stdlib.h>
+#include <math.h>
+#include "odds.h"
+#include "state.h"
+#include "infer.h"
+
+// Let p be the probability of the outcome, and k = 1 - c, where c is
+// the commission on winnings. Backing a stake of 1 at odds b has an
+// expected profit of p * (b - 1) * k - (1 - p), and laying it at odds
+// l has an expected profit of (1 - p) * k - p * (l - 1).
+//
+// Given p from the state, the participant backing at b makes
+// a profit on average exactly when k >= (1 - p) / (p * (b - 1)), and
+// the participant laying at l when k >= p * (l - 1) / (1 - p). Each
+// side therefore bounds the commission its participant can be paying,
+// with no need for a numerical search.
+//
+// Suppose instead that both sides were offered at zero expected profit
+// by participants paying the same commission, and that p is unknown.
+// Then (b - 1) = (1 - p) / (p * k) and (l - 1) = (1 - p) * k / p. Their
+// product is ((1 - p) / p)^2, and their ratio (l - 1) / (b - 1) is k^2,
+// which gives both p and k in closed form.
+//
+// An outcome which is certain or impossible is won or lost whatever
+// the odds, so its quotes bound neither p nor k, and every quantity is
+// NAN for it.
+//
+// Each quantity is computed for all observations in one loop over the
+// columns, which the compiler can vectorise. Empty sides give NAN.
+
+#define INITIAL_CAPACITY 1024
+
+static void growLadderObservations(struct ladderObservations* observations, int capacity) {
+  observations->capacity = capacity;
+  observations->sizes = realloc(observations->sizes, capacity * sizeof(int));
+  observations->numbersLower = realloc(observations->numbersLower, capacity * sizeof(int));
+  observations->outcomes = realloc(observations->outcomes, capacity * sizeof(int));
+  observations->backTicks = realloc(observations->backTicks, capacity * sizeof(int));
+  observations->layTicks = realloc(observations->layTicks, capacity * sizeof(int));
+  observations->fairProbabilities = realloc(observations->fairProbabilities, capacity * sizeof(double));
+  observations->impliedProbabilities = realloc(observations->impliedProbabilities, capacity * sizeof(double));
+  observations->impliedCommissions = realloc(observations->impliedCommissions, capacity * sizeof(double));
+  observations->backCommissions = realloc(observations->backCommissions, capacity * sizeof(double));
+  observations->layCommissions = realloc(observations->layCommissions, capacity * sizeof(double));
+}
+
+struct ladderObservations* createLadderObservations(int capacity) {
+  struct ladderObservations* observations = calloc(1, sizeof(struct ladderObservations));
+
+  growLadderObservations(observations, capacity > 0 ? capacity : INITIAL_CAPACITY);
+
+  return observations;
+}
+
+void freeLadderObservations(struct ladderObservations* observations) {
+  free(observations->sizes);
+  free(observations->numbersLower);
+  free(observations->outcomes);
+  free(observations->backTicks);
+  free(observations->layTicks);
+  free(observations->fairProbabilities);
+  free(observations->impliedProbabilities);
+  free(observations->impliedCommissions);
+  free(observations->backCommissions);
+  free(observations->layCommissions);
+  free(observations);
+}
+
+void addLadderObservation(struct ladderObservations* observations,
+                          int size,
+                          int numberLower,
+                          int outcome,
+                          int backTicks,
+                          int layTicks) {
+  int i = observations->length;
+
+  if (i == observations->capacity) {
+    growLadderObservations(observations, 2 * observations->capacity);
+  }
+
+  observations->sizes[i] = size;
+  observations->numbersLower[i] = numberLower;
+  observations->outcomes[i] = outcome;
+  observations->backTicks[i] = backTicks;
+  observations->layTicks[i] = layTicks;
+  observations->length++;
+}
+
+void inferCommissions(struct ladderObservations* observations, struct outcomeTable* table) {
+  int length = observations->length;
+  double* p = observations->fairProbabilities;
+
+  for (int i = 0; i < length; i++) {
+    p[i] = getOutcomeProbabilities(table, observations->sizes[i], observations->numbersLower[i])
+      [observations->outcomes[i]];
+  }
+
+  for (int i = 0; i < length; i++) {
+    double b = (double) observations->backTicks[i] / TICKS_IN_UNIT;
+    double l = (double) observations->layTicks[i] / TICKS_IN_UNIT;
+    double back = 1 - (1 - p[i]) / (p[i] * (b - 1));
+    double lay = 1 - (p[i] * (l - 1)) / (1 - p[i]);
+    double odds = sqrt((b - 1) * (l - 1));
+    double k = sqrt((l - 1) / (b - 1));
+    int open = p[i] > 0 && p[i] < 1;
+    int hasBack = open && observations->backTicks[i] > TICKS_IN_UNIT;
+    int hasLay = open && observations->layTicks[i] > TICKS_IN_UNIT;
+
+    observations->backCommissions[i] = hasBack ? back : NAN;
+    observations->layCommissions[i] = hasLay ? lay : NAN;
+    observations->impliedProbabilities[i] = hasBack && hasLay ? 1 / (1 + odds) : NAN;
+    observations->impliedCommissions[i] = hasBack && hasLay ? 1 - k : NAN;
+  }
+}
+
+struct commissionBounds* createCommissionBounds(struct outcomeTable* table) {
+  struct commissionBounds* bounds = malloc(sizeof(struct commissionBounds));
+  int length = getNumberOutcomeValues(table);
+
+  bounds->table = table;
+  bounds->bounds = calloc(length, sizeof(double));
+  bounds->lowestProbabilities = calloc(length, sizeof(double));
+  bounds->highestProbabilities = calloc(length, sizeof(double));
+  bounds->counts = calloc(length, sizeof(long));
+
+  for (int i = 0; i < length; i++) {
+    bounds->bounds[i] = NAN;
+    bounds->lowestProbabilities[i] = NAN;
+    bounds->highestProbabilities[i] = NAN;
+  }
+
+  return bounds;
+}
+
+void freeCommissionBounds(struct commissionBounds* bounds) {
+  free(bounds->bounds);
+  free(bounds->lowestProbabilities);
+  free(bounds->highestProbabilities);
+  free(bounds->counts);
+  free(bounds);
+}
+
+// The bounds are packed in the same way as the probabilities of the
+// outcome table.
+static long getBoundIndex(struct commissionBounds* bounds, int size, int numberLower, int outcome) {
+  return getOutcomeOffset(bounds->table, size, numberLower) + outcome;
+}
+
+// fmin and fmax ignore NAN, so empty sides and unobserved outcomes do
+// not affect the bounds.
+void accumulateCommissionBounds(struct commissionBounds* bounds,
+                                struct ladderObservations* observations) {
+  for (int i = 0; i < observations->length; i++) {
+    long index = getBoundIndex(bounds,
+                               observations->sizes[i],
+                               observations->numbersLower[i],
+                               observations->outcomes[i]);
+    double commission = fmin(observations->backCommissions[i], observations->layCommissions[i]);
+    double probability = observations->impliedProbabilities[i];
+
+    if (isnan(commission)) {
+      continue;
+    }
+
+    bounds->bounds[index] = fmin(bounds->bounds[index], commission);
+    bounds->lowestProbabilities[index] = fmin(bounds->lowestProbabilities[index], probability);
+    bounds->highestProbabilities[index] = fmax(bounds->highestProbabilities[index], probability);
+    bounds->counts[index]++;
+  }
+}
+
+double getCommissionBound(struct commissionBounds* bounds,
+                          int size,
+                          int numberLower,
+                          int outcome,
+                          long* count) {
+  long index = getBoundIndex(bounds, size, numberLower, outcome);
+
+  *count = bounds->counts[index];
+
+  return bounds->bounds[index];
+}
+
+void getImpliedProbabilityBounds(struct commissionBounds* bounds,
+                                 int size,
+                                 int numberLower,
+                                 int outcome,
+                                 double* lowest,
+                                 double* highest) {
+  long index = getBoundIndex(bounds, size, numberLower, outcome);
+
+  *lowest = bounds->lowestProbabilities[index];
+  *highest = bounds->highestProbabilities[index];
+}
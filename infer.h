@@ -0,0 +1,90 @@
+// Infer implied probabilities and commission rates from captured order
+// books. Each observation is of one outcome in one game state, and
+// holds the odds of the tightest back and lay orders placed by other
+// participants, in ticks, with 0 when a side is empty. As in the
+// README, the participants backing ask for odds above those of the
+// participants laying. The observations are held column by column,
+// so that they can be processed in bulk.
+
+struct ladderObservations {
+  int length;
+  int capacity;
+  int* sizes;
+  int* numbersLower;
+  int* outcomes;
+  int* backTicks;
+  int* layTicks;
+  // Filled in by `inferCommissions`.
+  double* fairProbabilities;
+  double* impliedProbabilities;
+  double* impliedCommissions;
+  double* backCommissions;
+  double* layCommissions;
+};
+
+struct ladderObservations* createLadderObservations(int capacity);
+
+void freeLadderObservations(struct ladderObservations* observations);
+
+void addLadderObservation(struct ladderObservations* observations,
+                          int size,
+                          int numberLower,
+                          int outcome,
+                          int backTicks,
+                          int layTicks);
+
+struct outcomeTable;
+
+// Work out, for every observation:
+//
+// - `fairProbabilities`, the probability of the outcome, from the
+//   outcome table.
+// - `backCommissions` and `layCommissions`, the highest commission at
+//   which the participant offering each side still makes a profit on
+//   average. These are NAN when the side is empty, or when the outcome
+//   is certain or impossible, so that any odds win or lose.
+// - `impliedProbabilities` and `impliedCommissions`, the probability
+//   and commission at which both sides would be offered exactly at
+//   zero expected profit. These are NAN unless both sides are offered.
+void inferCommissions(struct ladderObservations* observations, struct outcomeTable* table);
+
+// The lowest commission consistent with the tightest quotes seen for
+// each outcome and state, over any number of batches of observations:
+// the participants offering them cannot be paying more than this and
+// still make a profit on average. Alongside it, the range of the
+// probabilities implied by the observations with both sides offered.
+struct commissionBounds {
+  struct outcomeTable* table;
+  double* bounds;
+  double* lowestProbabilities;
+  double* highestProbabilities;
+  long* counts;
+};
+
+struct commissionBounds* createCommissionBounds(struct outcomeTable* table);
+
+void freeCommissionBounds(struct commissionBounds* bounds);
+
+// Lower the bounds by the back and lay commissions of a batch of
+// observations on which `inferCommissions` has been run, and widen the
+// ranges of implied probabilities. Observations with both sides empty
+// say nothing, and are not counted.
+void accumulateCommissionBounds(struct commissionBounds* bounds,
+                                struct ladderObservations* observations);
+
+// The bound for one outcome and state, or NAN if it has not been
+// observed. `count` is set to the number of observations.
+double getCommissionBound(struct commissionBounds* bounds,
+                          int size,
+                          int numberLower,
+                          int outcome,
+                          long* count);
+
+// The lowest and highest implied probability of one outcome and state,
+// both NAN if it has not been observed with both sides offered.
+void getImpliedProbabilityBounds(struct commissionBounds* bounds,
+                                 int size,
+                                 int numberLower,
+                                 int outcome,
+                                 double* lowest,
+                                 double* highest);
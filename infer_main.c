@@ -0,0 +1,90 @@
+#include <stdio.h>
+#include <math.h>
+#include "odds.h"
+#include "state.h"
+#include "infer.h"
+
+#define MAX_SIZE 13
+#define BATCH_SIZE 65536
+
+// Infer the commission bounds from captured order books. Each line of
+// input is an observation of the form "size number_lower outcome
+// back_odds lay_odds", where the odds are those of the tightest back
+// and lay orders (0 for an empty side), and outcome is the index of
+// the outcome as listed by the betting guide. For every outcome and
+// state observed with at least one side offered, print the number of
+// observations, the highest commission that the tightest participant
+// can be paying, and the range of the probabilities implied by the
+// observations with both sides offered (- if there were none).
+int main(void) {
+  struct outcomeTable* table = createOutcomeTable(MAX_SIZE);
+  struct ladderObservations* observations = createLadderObservations(BATCH_SIZE);
+  struct commissionBounds* bounds = createCommissionBounds(table);
+
+  int size;
+  int numberLower;
+  int outcome;
+  double backOdds;
+  double layOdds;
+
+  while (scanf("%d %d %d %lf %lf", &size, &numberLower, &outcome, &backOdds, &layOdds) == 5) {
+    if (size < 2 || size > MAX_SIZE || numberLower < 0 || numberLower > size
+        || outcome < 0 || outcome >= size - 1) {
+      continue;
+    }
+
+    // A certain or impossible outcome says nothing about commissions.
+    double probability = getOutcomeProbabilities(table, size, numberLower)[outcome];
+
+    if (probability <= 0 || probability >= 1) {
+      continue;
+    }
+
+    addLadderObservation(observations,
+                         size,
+                         numberLower,
+                         outcome,
+                         lround(backOdds * TICKS_IN_UNIT),
+                         lround(layOdds * TICKS_IN_UNIT));
+
+    if (observations->length == BATCH_SIZE) {
+      inferCommissions(observations, table);
+      accumulateCommissionBounds(bounds, observations);
+      observations->length = 0;
+    }
+  }
+
+  inferCommissions(observations, table);
+  accumulateCommissionBounds(bounds, observations);
+
+  for (size = 2; size <= MAX_SIZE; size++) {
+    for (numberLower = 0; numberLower <= size; numberLower++) {
+      for (outcome = 0; outcome < size - 1; outcome++) {
+        long count;
+        double bound = getCommissionBound(bounds, size, numberLower, outcome, &count);
+        double lowest;
+        double highest;
+
+        getImpliedProbabilityBounds(bounds, size, numberLower, outcome, &lowest, &highest);
+
+        if (count == 0) {
+          continue;
+        }
+
+        printf("S: %d -- L: %d -- O: %d -- N: %ld -- C: %.4f -- P: ", size, numberLower, outcome, count, bound);
+
+        if (isnan(lowest)) {
+          printf("-\n");
+        } else {
+          printf("%.4f..%.4f\n", lowest, highest);
+        }
+      }
+    }
+  }
+
+  freeCommissionBounds(bounds);
+  freeLadderObservations(observations);
+  freeOutcomeTable(table);
+
+  return 0;
+}
@@ -1,19 +1,20 @@
 #include <stdio.h>
-#include <math.h>
 #include <assert.h>
 #include "prob.h"
+#include "odds.h"
 
 #define MAX_SIZE 13
 
 #define COMMISSION 0.03
-#define TICKS_IN_UNIT 100
 
-void printOdds(unsigned long int numerator, unsigned long int denominator);
+void printOdds(double probability, int backTicks, int layTicks);
 
 // This is the betting guide. The game state is defined by the number of cards remaining in the deck = number_remaining, and the number of cards remaining in the deck that are lower than the last played card = number_lower. Input game states on the terminal in the form "number_remaining number_lower" to display the probabilities and tightest profitable backing and laying odds of all subsequent possible outcomes
 int main(void) {
   unsigned long int* numeratorsResult = createProbabilitiesResult(MAX_SIZE);
   unsigned long int* denominatorsResult = createProbabilitiesResult(MAX_SIZE);
+  double probabilities[MAX_SIZE];
+  double errors[MAX_SIZE];
 
   int size;
   int numberLower;
@@ -22,42 +23,64 @@ int main(void) {
     assert(size <= MAX_SIZE);
 
     int lengthOfProbabilities = getLengthOfProbabilities(size);
+    int backTicks[MAX_SIZE];
+    int layTicks[MAX_SIZE];
+    int closeOutcomes[MAX_SIZE];
+    int numberClose = 0;
 
-    calculateProbabilities(numeratorsResult, denominatorsResult, size, numberLower);
+    calculateProbabilitiesApproximately(probabilities, errors, size, numberLower);
 
+    // The double probabilities almost always determine the ticks. Only
+    // when a probability is too close to a boundary between ticks do we
+    // need the exact probability, and then only of those outcomes,
+    // which are computed together once for the state.
     for (int i = 0; i < lengthOfProbabilities; i++) {
-      printOdds(numeratorsResult[i], denominatorsResult[i]);
+      if (!calculateBoundedBackTicks(probabilities[i], errors[i], COMMISSION, &backTicks[i])
+          || !calculateBoundedLayTicks(probabilities[i], errors[i], COMMISSION, &layTicks[i])) {
+        closeOutcomes[numberClose++] = i;
+      }
+    }
+
+    if (numberClose > 0) {
+      calculateSelectedProbabilities(numeratorsResult,
+                                     denominatorsResult,
+                                     closeOutcomes,
+                                     numberClose,
+                                     size,
+                                     numberLower);
+
+      for (int k = 0; k < numberClose; k++) {
+        int i = closeOutcomes[k];
+
+        backTicks[i] = calculateExactBackTicks(numeratorsResult[k], denominatorsResult[k], COMMISSION);
+        layTicks[i] = calculateExactLayTicks(numeratorsResult[k], denominatorsResult[k], COMMISSION);
+      }
+    }
+
+    for (int i = 0; i < lengthOfProbabilities; i++) {
+      printOdds(probabilities[i], backTicks[i], layTicks[i]);
     }
   }
 
   return 0;
 }
 
-double calculate_tightest_back_odds(double probability) {
-  double k = 1 - COMMISSION;
-  double zero_payoff_odds = ((probability * k) + 1 - probability) / (probability * k);
-  double number_ticks = floor(zero_payoff_odds * TICKS_IN_UNIT);
-  double one_tick_wider = number_ticks + 1;
-  double tightest_back_odds = one_tick_wider / TICKS_IN_UNIT;
-
-  return tightest_back_odds;
+// Ticks with no profitable odds on the ladder are printed as "--".
+static void formatTicks(char* text, int ticks) {
+  if (ticks == NO_ODDS_TICKS) {
+    sprintf(text, "--");
+  } else {
+    sprintf(text, "%.2f", (double) ticks / TICKS_IN_UNIT);
+  }
 }
 
-double calculate_tightest_lay_odds(double probability) {
-  double k = 1 - COMMISSION;
-  double zero_payoff_odds = (k - (probability * k) + probability) / probability;
-  double number_ticks = ceil(zero_payoff_odds * TICKS_IN_UNIT);
-  double one_tick_wider = number_ticks - 1;
-  double tightest_lay_odds = one_tick_wider / TICKS_IN_UNIT;
-
-  return tightest_lay_odds;
-}
+void printOdds(double probability, int backTicks, int layTicks) {
+  double odds = 1 / probability;
+  char tightest_back_odds[16];
+  char tightest_lay_odds[16];
 
-void printOdds(unsigned long int numerator, unsigned long int denominator) {
-  double probability = (double) numerator / (double) denominator;
-  double odds = (double) denominator / (double) numerator;
-  double tightest_back_odds = calculate_tightest_back_odds(probability);
-  double tightest_lay_odds = calculate_tightest_lay_odds(probability);
+  formatTicks(tightest_back_odds, backTicks);
+  formatTicks(tightest_lay_odds, layTicks);
 
-  printf("P: %.3f -- O: %.3f -- B: %.2f -- L: %.2f\n", probability, odds, tightest_back_odds, tightest_lay_odds);
+  printf("P: %.3f -- O: %.3f -- B: %s -- L: %s\n", probability, odds, tightest_back_odds, tightest_lay_odds);
 }
@@ -0,0 +1,230 @@
+#include <stdlib.h>
+#include "prob.h"
+#include "mdp.h"
+#include "odds.h"
+#include "state.h"
+
+// Suppose we start trading in the state (size, numberLower). The
+// outcome at index n of this starting state (see prob.c) is that the
+// computer predicts the next (n + 1) deals correctly. After d correct
+// deals, the game is in a state with (size - d) cards remaining, and
+// the outcome is decided by whether the remaining (n + 1 - d) deals
+// are predicted correctly. As soon as a prediction fails the outcome
+// is lost, and once (n + 1) deals have been predicted correctly it is
+// won. Either way, no more trading happens in that outcome.
+//
+// We pay commission on the winnings of each bet. The expected profit
+// of a bet is then fixed at the moment it is matched, and is given by
+// `calculateBackExpectedValue` and `calculateLayExpectedValue` in
+// odds.c. Our position in an outcome matters because it limits which
+// trades we may make later, and because of the cost of carrying it
+// through a deal.
+//
+// Neither the payoffs nor the limits on one outcome depend on our
+// position in another. The value of a position in all outcomes is
+// therefore the sum of the values of the positions in each outcome,
+// and the decision process separates into one process per outcome,
+// each with the state (size, numberLower, position). We solve each of
+// these by backward induction over the sizes of the deck.
+//
+// The values and actions are packed by outcome, then by game state as
+// in state.h, and then by position.
+
+void quoteLadderModel(void* context,
+                      int size,
+                      int numberLower,
+                      double probability,
+                      int* backTicks,
+                      int* layTicks) {
+  struct ladderModel* model = context;
+
+  modelMarketTicks(probability, model->marketCommission, model->offsetTicks, backTicks, layTicks);
+}
+
+static int getNumberPositions(int maxPosition) {
+  return 2 * maxPosition + 1;
+}
+
+static int getPolicyIndex(struct tradingPolicy* policy,
+                          int outcome,
+                          int size,
+                          int numberLower,
+                          int position) {
+  int stateIndex = outcome * policy->numberStates + getStateIndex(size, numberLower);
+
+  return stateIndex * getNumberPositions(policy->maxPosition) + position + policy->maxPosition;
+}
+
+static struct tradingPolicy* createTradingPolicy(int size, int numberLower, int maxPosition) {
+  struct tradingPolicy* policy = malloc(sizeof(struct tradingPolicy));
+  int numberOutcomes = getLengthOfProbabilities(size);
+  int length;
+
+  policy->size = size;
+  policy->numberLower = numberLower;
+  policy->maxPosition = maxPosition;
+  policy->numberOutcomes = numberOutcomes;
+  policy->numberStates = getNumberStates(size);
+
+  length = numberOutcomes * policy->numberStates * getNumberPositions(maxPosition);
+  policy->values = calloc(length, sizeof(double));
+  policy->actions = calloc(length, sizeof(signed char));
+
+  return policy;
+}
+
+// The expected profit from the next betting window onwards, of
+// holding each position after trading in the state (size,
+// numberLower). `remaining` is the number of deals which still need
+// to be predicted correctly for the outcome to be won. If only one
+// remains, the outcome is settled by the next deal.
+static void calculateContinuationValues(struct tradingPolicy* policy,
+                                        struct tradingParameters* parameters,
+                                        double* continuationValues,
+                                        int outcome,
+                                        int size,
+                                        int numberLower,
+                                        int remaining) {
+  int maxPosition = policy->maxPosition;
+
+  for (int position = -maxPosition; position <= maxPosition; position++) {
+    double sum = 0;
+
+    if (remaining > 1) {
+      for (int i = 0; i < size; i++) {
+        if (isCorrectPrediction(size, numberLower, i)) {
+          sum += policy->values[getPolicyIndex(policy, outcome, size - 1, i, position)];
+        }
+      }
+    }
+
+    continuationValues[position + maxPosition] = (sum / size)
+      - parameters->holdingCost * abs(position);
+  }
+}
+
+// Choose the best number of units to trade when holding each
+// position in the state (size, numberLower). Prefer holding, and then
+// smaller trades, when the values are equal.
+static void solveState(struct tradingPolicy* policy,
+                       struct tradingParameters* parameters,
+                       double* continuationValues,
+                       double probability,
+                       int outcome,
+                       int size,
+                       int numberLower) {
+  int maxPosition = policy->maxPosition;
+  int backTicks;
+  int layTicks;
+
+  parameters->quote(parameters->quoteContext, size, numberLower, probability, &backTicks, &layTicks);
+
+  double backValue = calculateBackExpectedValue(probability, backTicks, parameters->commission);
+  double layValue = calculateLayExpectedValue(probability, layTicks, parameters->commission);
+
+  for (int position = -maxPosition; position <= maxPosition; position++) {
+    int bestAction = 0;
+    double bestValue = continuationValues[position + maxPosition];
+
+    for (int units = 1; units <= parameters->maxTradeSize; units++) {
+      if (backTicks != 0 && position + units <= maxPosition) {
+        double value = units * backValue + continuationValues[position + units + maxPosition];
+
+        if (value > bestValue) {
+          bestAction = units;
+          bestValue = value;
+        }
+      }
+
+      if (layTicks != 0 && position - units >= -maxPosition) {
+        double value = units * layValue + continuationValues[position - units + maxPosition];
+
+        if (value > bestValue) {
+          bestAction = -units;
+          bestValue = value;
+        }
+      }
+    }
+
+    int index = getPolicyIndex(policy, outcome, size, numberLower, position);
+
+    policy->values[index] = bestValue;
+    policy->actions[index] = bestAction;
+  }
+}
+
+// Solve the decision process of one outcome. The states in which the
+// outcome is still open have between (size - outcome) and `size`
+// cards remaining. Each of them only depends on states with one card
+// fewer, so we solve them from the smallest deck up.
+static void solveOutcome(struct tradingPolicy* policy,
+                         struct tradingParameters* parameters,
+                         struct outcomeTable* table,
+                         double* continuationValues,
+                         int outcome) {
+  for (int size = policy->size - outcome; size <= policy->size; size++) {
+    int remaining = outcome + 1 - (policy->size - size);
+
+    for (int numberLower = 0; numberLower <= size; numberLower++) {
+      double probability = getOutcomeProbabilities(table, size, numberLower)[remaining - 1];
+
+      calculateContinuationValues(policy,
+                                  parameters,
+                                  continuationValues,
+                                  outcome,
+                                  size,
+                                  numberLower,
+                                  remaining);
+      solveState(policy, parameters, continuationValues, probability, outcome, size, numberLower);
+    }
+  }
+}
+
+struct tradingPolicy* solveTradingPolicy(struct tradingParameters* parameters,
+                                         int size,
+                                         int numberLower) {
+  struct tradingPolicy* policy = createTradingPolicy(size, numberLower, parameters->maxPosition);
+  struct outcomeTable* table = createOutcomeTable(size);
+  double* continuationValues = calloc(getNumberPositions(parameters->maxPosition), sizeof(double));
+
+  for (int outcome = 0; outcome < policy->numberOutcomes; outcome++) {
+    solveOutcome(policy, parameters, table, continuationValues, outcome);
+  }
+
+  freeOutcomeTable(table);
+  free(continuationValues);
+
+  return policy;
+}
+
+void freeTradingPolicy(struct tradingPolicy* policy) {
+  free(policy->values);
+  free(policy->actions);
+  free(policy);
+}
+
+int getTradingAction(struct tradingPolicy* policy,
+                     int outcome,
+                     int size,
+                     int numberLower,
+                     int position) {
+  return policy->actions[getPolicyIndex(policy, outcome, size, numberLower, position)];
+}
+
+double getTradingValue(struct tradingPolicy* policy,
+                       int outcome,
+                       int size,
+                       int numberLower,
+                       int position) {
+  return policy->values[getPolicyIndex(policy, outcome, size, numberLower, position)];
+}
+
+double getTotalTradingValue(struct tradingPolicy* policy) {
+  double sum = 0;
+
+  for (int outcome = 0; outcome < policy->numberOutcomes; outcome++) {
+    sum += getTradingValue(policy, outcome, policy->size, policy->numberLower, 0);
+  }
+
+  return sum;
+}
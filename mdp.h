@@ -0,0 +1,82 @@
+// Treat trading on a whole game as a Markov decision process. The
+// state is the game state (see state.h), together with our position
+// in each outcome, measured in units of stake backed (positive) or
+// laid (negative). At each betting window we can back, lay or hold
+// each outcome at the prices on the ladder.
+
+// A market made by participants paying `marketCommission`, quoting
+// `offsetTicks` ticks wider than their tightest profitable odds.
+struct ladderModel {
+  double marketCommission;
+  int offsetTicks;
+};
+
+// A quote function for `struct tradingParameters` which models the
+// ladder with `modelMarketTicks` in odds.h. The context is a `struct
+// ladderModel`.
+void quoteLadderModel(void* context,
+                      int size,
+                      int numberLower,
+                      double probability,
+                      int* backTicks,
+                      int* layTicks);
+
+struct tradingParameters {
+  // The commission we pay on winnings.
+  double commission;
+  // The largest position we may hold in any one outcome.
+  int maxPosition;
+  // The largest number of units we may trade in one betting window.
+  int maxTradeSize;
+  // The cost charged per unit of position carried through a deal.
+  double holdingCost;
+  // The prices available to us on the ladder for an outcome with fair
+  // probability `probability`, in the game state (size,
+  // numberLower). A tick value of 0 means that no price is available.
+  void (*quote)(void* context,
+                int size,
+                int numberLower,
+                double probability,
+                int* backTicks,
+                int* layTicks);
+  void* quoteContext;
+};
+
+struct tradingPolicy {
+  int size;
+  int numberLower;
+  int maxPosition;
+  int numberOutcomes;
+  int numberStates;
+  double* values;
+  signed char* actions;
+};
+
+// Find the value maximising trading policy for the game starting in
+// the state (size, numberLower), by backward induction.
+struct tradingPolicy* solveTradingPolicy(struct tradingParameters* parameters,
+                                         int size,
+                                         int numberLower);
+
+void freeTradingPolicy(struct tradingPolicy* policy);
+
+// The number of units to back (positive) or lay (negative) in
+// `outcome`, an index into the outcomes of the starting state, when
+// the game has reached the state (size, numberLower) with the streak
+// intact, and we hold `position`.
+int getTradingAction(struct tradingPolicy* policy,
+                     int outcome,
+                     int size,
+                     int numberLower,
+                     int position);
+
+// The expected profit of following the policy from the same state.
+double getTradingValue(struct tradingPolicy* policy,
+                       int outcome,
+                       int size,
+                       int numberLower,
+                       int position);
+
+// The expected profit of following the policy in every outcome from
+// the starting state with no position.
+double getTotalTradingValue(struct tradingPolicy* policy);
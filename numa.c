@@ -0,0 +1,324 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "pool.h"
+#include "state.h"
+#include "numa.h"
+
+// Each node's replica lives in that node's memory. Linux places a page
+// on the node of the thread which first writes to it, so every replica
+// is allocated and filled in by a thread pinned to its node. The
+// counts of readers of each replica are in the same allocation, each
+// on its own cache line, so that readers on a node only touch memory
+// of that node, apart from reading the epoch, which rarely changes.
+//
+// An update swaps the new replicas in, and must then wait until every
+// reader which might have acquired an old one has released it. Readers
+// count themselves in one of two counters, chosen by the parity of the
+// epoch. Any reader which acquired an old replica counted itself
+// before the swap, so once both counters have been seen at 0 after the
+// swap, no reader holds an old replica. The update flips the epoch
+// before waiting for each counter, so that new readers count
+// themselves in the other one, and the wait cannot be starved by a
+// stream of new readers.
+
+#define CACHE_LINE 64
+#define MAX_NODES 1024
+
+struct tableReplica {
+  _Alignas(CACHE_LINE) _Atomic(struct outcomeTable*) table;
+  _Alignas(CACHE_LINE) atomic_long readers[2];
+};
+
+// Parse a list of processors such as "0-3,8-11" into `cpus`, and
+// return how many there are. With `cpus` NULL, only count them.
+// Processors from CPU_SETSIZE on cannot be pinned to with a cpu_set_t,
+// and are left out.
+static int parseCpuList(const char* list, int* cpus) {
+  int number = 0;
+  char* end;
+
+  while (*list != '\0' && *list != '\n') {
+    long first = strtol(list, &end, 10);
+    long last = first;
+
+    if (end == list) {
+      break;
+    }
+
+    if (*end == '-') {
+      list = end + 1;
+      last = strtol(list, &end, 10);
+    }
+
+    first = first > 0 ? first : 0;
+    last = last < CPU_SETSIZE - 1 ? last : CPU_SETSIZE - 1;
+
+    for (long cpu = first; cpu <= last; cpu++) {
+      if (cpus != NULL) {
+        cpus[number] = cpu;
+      }
+
+      number++;
+    }
+
+    list = *end == ',' ? end + 1 : end;
+  }
+
+  return number;
+}
+
+static char* readNodeCpuList(int node) {
+  char path[64];
+  char* list = calloc(4096, 1);
+
+  snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+
+  FILE* file = fopen(path, "r");
+
+  if (file == NULL || fgets(list, 4096, file) == NULL) {
+    if (file != NULL) {
+      fclose(file);
+    }
+
+    free(list);
+
+    return NULL;
+  }
+
+  fclose(file);
+
+  return list;
+}
+
+// Nodes are numbered from 0, and nodes without processors are left
+// out, as no worker can run on them.
+struct numaTopology* detectNumaTopology(void) {
+  struct numaTopology* topology = malloc(sizeof(struct numaTopology));
+  char* lists[MAX_NODES];
+  int numberLists = 0;
+  int numberCpus = 0;
+
+  for (int node = 0; node < MAX_NODES; node++) {
+    char* list = readNodeCpuList(node);
+
+    if (list == NULL) {
+      continue;
+    }
+
+    int number = parseCpuList(list, NULL);
+
+    if (number == 0) {
+      free(list);
+      continue;
+    }
+
+    lists[numberLists++] = list;
+    numberCpus += number;
+  }
+
+  if (numberLists == 0) {
+    numberCpus = getNumberProcessors();
+    topology->numberNodes = 1;
+    topology->cpuOffsets = calloc(2, sizeof(int));
+    topology->cpus = calloc(numberCpus, sizeof(int));
+    topology->cpuOffsets[1] = numberCpus;
+
+    for (int cpu = 0; cpu < numberCpus; cpu++) {
+      topology->cpus[cpu] = cpu;
+    }
+
+    return topology;
+  }
+
+  topology->numberNodes = numberLists;
+  topology->cpuOffsets = calloc(numberLists + 1, sizeof(int));
+  topology->cpus = calloc(numberCpus, sizeof(int));
+
+  for (int node = 0; node < numberLists; node++) {
+    int number = parseCpuList(lists[node], &topology->cpus[topology->cpuOffsets[node]]);
+
+    topology->cpuOffsets[node + 1] = topology->cpuOffsets[node] + number;
+    free(lists[node]);
+  }
+
+  return topology;
+}
+
+void freeNumaTopology(struct numaTopology* topology) {
+  free(topology->cpuOffsets);
+  free(topology->cpus);
+  free(topology);
+}
+
+int getNodeOfWorker(struct numaTopology* topology, int worker) {
+  return worker % topology->numberNodes;
+}
+
+int pinToNode(struct numaTopology* topology, int node) {
+  cpu_set_t set;
+
+  CPU_ZERO(&set);
+
+  for (int i = topology->cpuOffsets[node]; i < topology->cpuOffsets[node + 1]; i++) {
+    if (topology->cpus[i] >= 0 && topology->cpus[i] < CPU_SETSIZE) {
+      CPU_SET(topology->cpus[i], &set);
+    }
+  }
+
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+void pinWorkerToNode(void* topology, int worker) {
+  pinToNode(topology, getNodeOfWorker(topology, worker));
+}
+
+static struct outcomeTable* copyOutcomeTable(struct outcomeTable* table) {
+  struct outcomeTable* copy = malloc(sizeof(struct outcomeTable));
+  int numberValues = getNumberOutcomeValues(table);
+
+  copy->maxSize = table->maxSize;
+  copy->sizeOffsets = malloc((table->maxSize + 2) * sizeof(int));
+  copy->probabilities = malloc(numberValues * sizeof(double));
+  memcpy(copy->sizeOffsets, table->sizeOffsets, (table->maxSize + 2) * sizeof(int));
+  memcpy(copy->probabilities, table->probabilities, numberValues * sizeof(double));
+
+  return copy;
+}
+
+struct replicaBuild {
+  struct numaTopology* topology;
+  int node;
+  struct outcomeTable* source;
+  struct outcomeTable* copy;
+  struct tableReplica* replica;
+  int createReplica;
+};
+
+static void* buildReplica(void* argument) {
+  struct replicaBuild* build = argument;
+
+  pinToNode(build->topology, build->node);
+  build->copy = copyOutcomeTable(build->source);
+
+  if (build->createReplica) {
+    build->replica = aligned_alloc(CACHE_LINE, sizeof(struct tableReplica));
+    atomic_init(&build->replica->table, build->copy);
+    atomic_init(&build->replica->readers[0], 0);
+    atomic_init(&build->replica->readers[1], 0);
+  }
+
+  return NULL;
+}
+
+// Copy `table` on every node at once, with a thread pinned to each.
+static struct replicaBuild* buildReplicas(struct numaTopology* topology,
+                                          struct outcomeTable* table,
+                                          int createReplicas) {
+  int numberNodes = topology->numberNodes;
+  struct replicaBuild* builds = calloc(numberNodes, sizeof(struct replicaBuild));
+  pthread_t* threads = calloc(numberNodes, sizeof(pthread_t));
+
+  for (int node = 0; node < numberNodes; node++) {
+    builds[node].topology = topology;
+    builds[node].node = node;
+    builds[node].source = table;
+    builds[node].createReplica = createReplicas;
+    pthread_create(&threads[node], NULL, buildReplica, &builds[node]);
+  }
+
+  for (int node = 0; node < numberNodes; node++) {
+    pthread_join(threads[node], NULL);
+  }
+
+  free(threads);
+
+  return builds;
+}
+
+struct replicatedTable* createReplicatedTable(struct numaTopology* topology, struct outcomeTable* table) {
+  struct replicatedTable* replicated = malloc(sizeof(struct replicatedTable));
+  struct replicaBuild* builds = buildReplicas(topology, table, 1);
+
+  replicated->topology = topology;
+  replicated->replicas = calloc(topology->numberNodes, sizeof(struct tableReplica*));
+  atomic_init(&replicated->epoch, 0);
+  atomic_init(&replicated->version, 0);
+  pthread_mutex_init(&replicated->updateMutex, NULL);
+
+  for (int node = 0; node < topology->numberNodes; node++) {
+    replicated->replicas[node] = builds[node].replica;
+  }
+
+  free(builds);
+
+  return replicated;
+}
+
+void freeReplicatedTable(struct replicatedTable* replicated) {
+  for (int node = 0; node < replicated->topology->numberNodes; node++) {
+    freeOutcomeTable(atomic_load(&replicated->replicas[node]->table));
+    free(replicated->replicas[node]);
+  }
+
+  pthread_mutex_destroy(&replicated->updateMutex);
+  free(replicated->replicas);
+  free(replicated);
+}
+
+struct outcomeTable* acquireReplica(struct replicatedTable* replicated, int node, int* ticket) {
+  struct tableReplica* replica = replicated->replicas[node];
+
+  *ticket = atomic_load(&replicated->epoch) & 1;
+  atomic_fetch_add(&replica->readers[*ticket], 1);
+
+  return atomic_load(&replica->table);
+}
+
+void releaseReplica(struct replicatedTable* replicated, int node, int ticket) {
+  atomic_fetch_sub(&replicated->replicas[node]->readers[ticket], 1);
+}
+
+// Flip the epoch, and wait for the readers counted under the old one.
+static void waitForReaders(struct replicatedTable* replicated) {
+  int parity = atomic_fetch_add(&replicated->epoch, 1) & 1;
+
+  for (int node = 0; node < replicated->topology->numberNodes; node++) {
+    while (atomic_load(&replicated->replicas[node]->readers[parity]) > 0) {
+      sched_yield();
+    }
+  }
+}
+
+void updateReplicatedTable(struct replicatedTable* replicated, struct outcomeTable* table) {
+  int numberNodes = replicated->topology->numberNodes;
+  struct replicaBuild* builds = buildReplicas(replicated->topology, table, 0);
+  struct outcomeTable** oldTables = calloc(numberNodes, sizeof(struct outcomeTable*));
+
+  pthread_mutex_lock(&replicated->updateMutex);
+
+  for (int node = 0; node < numberNodes; node++) {
+    oldTables[node] = atomic_exchange(&replicated->replicas[node]->table, builds[node].copy);
+  }
+
+  atomic_fetch_add(&replicated->version, 1);
+  waitForReaders(replicated);
+  waitForReaders(replicated);
+
+  pthread_mutex_unlock(&replicated->updateMutex);
+
+  for (int node = 0; node < numberNodes; node++) {
+    freeOutcomeTable(oldTables[node]);
+  }
+
+  free(oldTables);
+  free(builds);
+}
+
+long getReplicatedTableVersion(struct replicatedTable* replicated) {
+  return atomic_load(&replicated->version);
+}
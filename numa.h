@@ -0,0 +1,60 @@
+#include <pthread.h>
+#include <stdatomic.h>
+
+// The processors of each NUMA node, read from sysfs. On machines
+// without NUMA, or where sysfs is unavailable, every processor is on
+// a single node 0.
+struct numaTopology {
+  int numberNodes;
+  // The processors of node n are cpus[cpuOffsets[n]] up to
+  // cpus[cpuOffsets[n + 1]].
+  int* cpuOffsets;
+  int* cpus;
+};
+
+struct numaTopology* detectNumaTopology(void);
+
+void freeNumaTopology(struct numaTopology* topology);
+
+// Workers are spread over the nodes in turn.
+int getNodeOfWorker(struct numaTopology* topology, int worker);
+
+// Restrict the calling thread to the processors of `node`. Return 1 on
+// success and 0 otherwise.
+int pinToNode(struct numaTopology* topology, int node);
+
+// Pin a worker of a pool to its node, for `createStartedWorkPool` in
+// pool.h, with the topology as the argument.
+void pinWorkerToNode(void* topology, int worker);
+
+// An outcome table (see state.h) replicated into the memory of every
+// node, so that lookups never cross to another socket. Readers on a
+// node acquire that node's replica, and release it when they are done.
+// An update replaces every replica, and frees the old ones once no
+// reader holds them.
+struct tableReplica;
+
+struct replicatedTable {
+  struct numaTopology* topology;
+  struct tableReplica** replicas;
+  atomic_int epoch;
+  atomic_long version;
+  pthread_mutex_t updateMutex;
+};
+
+// Replicate a copy of `table`, which remains the caller's.
+struct replicatedTable* createReplicatedTable(struct numaTopology* topology, struct outcomeTable* table);
+
+void freeReplicatedTable(struct replicatedTable* replicated);
+
+// The replica of `node`, which stays valid until it is released with
+// the `ticket` set here.
+struct outcomeTable* acquireReplica(struct replicatedTable* replicated, int node, int* ticket);
+
+void releaseReplica(struct replicatedTable* replicated, int node, int ticket);
+
+// Replace every replica with a copy of `table`, and increment the
+// version. Return once the old replicas have been freed.
+void updateReplicatedTable(struct replicatedTable* replicated, struct outcomeTable* table);
+
+long getReplicatedTableVersion(struct replicatedTable* replicated);
@@ -0,0 +1,250 @@
+#include <math.h>
+#include <float.h>
+#include "gmp.h"
+#include "odds.h"
+
+// Backing a stake of 1 at `odds` wins (odds - 1) less commission
+// with probability `probability`, and loses the stake otherwise. The
+// odds with zero expected payoff are rounded down to a tick, and then
+// moved one tick wider.
+double calculate_tightest_back_odds(double probability, double commission) {
+  double k = 1 - commission;
+  double zero_payoff_odds = ((probability * k) + 1 - probability) / (probability * k);
+  double number_ticks = floor(zero_payoff_odds * TICKS_IN_UNIT);
+  double one_tick_wider = number_ticks + 1;
+  double tightest_back_odds = one_tick_wider / TICKS_IN_UNIT;
+
+  return tightest_back_odds;
+}
+
+// Laying a stake of 1 at `odds` wins the stake less commission with
+// probability (1 - `probability`), and loses (odds - 1) otherwise.
+double calculate_tightest_lay_odds(double probability, double commission) {
+  double k = 1 - commission;
+  double zero_payoff_odds = (k - (probability * k) + probability) / probability;
+  double number_ticks = ceil(zero_payoff_odds * TICKS_IN_UNIT);
+  double one_tick_wider = number_ticks - 1;
+  double tightest_lay_odds = one_tick_wider / TICKS_IN_UNIT;
+
+  return tightest_lay_odds;
+}
+
+// Keep the tightest back ticks on the ladder. Any higher odds are
+// profitable too, but none lower are.
+static int clampBackTicks(long ticks) {
+  if (ticks > MAX_ODDS_TICKS) {
+    return NO_ODDS_TICKS;
+  }
+
+  return ticks < MIN_ODDS_TICKS ? MIN_ODDS_TICKS : ticks;
+}
+
+// Any lower lay odds are profitable too, but none higher are.
+static int clampLayTicks(long ticks) {
+  if (ticks < MIN_ODDS_TICKS) {
+    return NO_ODDS_TICKS;
+  }
+
+  return ticks > MAX_ODDS_TICKS ? MAX_ODDS_TICKS : ticks;
+}
+
+// An outcome which cannot happen has no finite zero payoff odds.
+// Backing it always loses, and laying it at any odds wins.
+int calculateTightestBackTicks(double probability, double commission) {
+  if (probability <= 0) {
+    return NO_ODDS_TICKS;
+  }
+
+  return clampBackTicks(lround(calculate_tightest_back_odds(probability, commission) * TICKS_IN_UNIT));
+}
+
+int calculateTightestLayTicks(double probability, double commission) {
+  if (probability <= 0) {
+    return MAX_ODDS_TICKS;
+  }
+
+  return clampLayTicks(lround(calculate_tightest_lay_odds(probability, commission) * TICKS_IN_UNIT));
+}
+
+double calculateBackExpectedValue(double probability, int ticks, double commission) {
+  double winnings = ((double) ticks / TICKS_IN_UNIT) - 1;
+
+  return (probability * winnings * (1 - commission)) - (1 - probability);
+}
+
+double calculateLayExpectedValue(double probability, int ticks, double commission) {
+  double liability = ((double) ticks / TICKS_IN_UNIT) - 1;
+
+  return ((1 - probability) * (1 - commission)) - (probability * liability);
+}
+
+void modelMarketTicks(double probability,
+                      double marketCommission,
+                      int offsetTicks,
+                      int* backTicks,
+                      int* layTicks) {
+  int marketLayTicks = calculateTightestLayTicks(probability, marketCommission);
+  int marketBackTicks = calculateTightestBackTicks(probability, marketCommission);
+
+  *backTicks = marketLayTicks == NO_ODDS_TICKS ? NO_ODDS_TICKS : clampLayTicks(marketLayTicks - offsetTicks);
+  *layTicks = marketBackTicks == NO_ODDS_TICKS ? NO_ODDS_TICKS : clampBackTicks(marketBackTicks + offsetTicks);
+}
+
+// The zero payoff odds, in ticks, of backing and laying. Both decrease
+// as the probability increases.
+static double getBackZeroPayoffTicks(double probability, double k) {
+  return TICKS_IN_UNIT * (1 + (1 - probability) / (probability * k));
+}
+
+static double getLayZeroPayoffTicks(double probability, double k) {
+  return TICKS_IN_UNIT * (1 + k * (1 - probability) / probability);
+}
+
+// The zero payoff ticks over the whole range of probabilities lie
+// between their values at the ends of the range, which is cut off at a
+// probability of 1. Those are computed
+// with a few roundings, each of relative error at most half of
+// DBL_EPSILON, so the range is widened by a few DBL_EPSILON more. The
+// ticks are certain when the widened range does not cross a multiple
+// of a tick.
+static int getTicksRange(double (*getZeroPayoffTicks)(double, double),
+                         double probability,
+                         double error,
+                         double commission,
+                         double* lowest,
+                         double* highest) {
+  if (probability - error <= 0) {
+    return 0;
+  }
+
+  double k = 1 - commission;
+
+  *lowest = floor(getZeroPayoffTicks(fmin(probability + error, 1), k) * (1 - 4 * DBL_EPSILON));
+  *highest = floor(getZeroPayoffTicks(probability - error, k) * (1 + 4 * DBL_EPSILON));
+
+  return 1;
+}
+
+int calculateBoundedBackTicks(double probability, double error, double commission, int* ticks) {
+  double lowest;
+  double highest;
+
+  if (!getTicksRange(getBackZeroPayoffTicks, probability, error, commission, &lowest, &highest)
+      || lowest != highest) {
+    return 0;
+  }
+
+  *ticks = clampBackTicks(fmin(lowest + 1, MAX_ODDS_TICKS + 1));
+
+  return 1;
+}
+
+// The lay ticks round the zero payoff ticks up, so the range must not
+// contain a whole number of ticks either, which is when the two ends
+// round down to the same whole number and the range does not start on
+// it.
+int calculateBoundedLayTicks(double probability, double error, double commission, int* ticks) {
+  double lowest;
+  double highest;
+  double k = 1 - commission;
+
+  if (!getTicksRange(getLayZeroPayoffTicks, probability, error, commission, &lowest, &highest)
+      || lowest != highest
+      || getLayZeroPayoffTicks(fmin(probability + error, 1), k) * (1 - 4 * DBL_EPSILON) <= lowest) {
+    return 0;
+  }
+
+  *ticks = clampLayTicks(fmin(lowest, MAX_ODDS_TICKS + 1));
+
+  return 1;
+}
+
+// Set `ticks` to (TICKS_IN_UNIT * `odds`) rounded down or up, for the
+// zero payoff odds `odds` of an exact probability
+// numerator / denominator. The commission is taken to be exactly the
+// double `commission`.
+static void calculateExactZeroPayoffTicks(mpz_t ticks,
+                                          unsigned long int numerator,
+                                          unsigned long int denominator,
+                                          double commission,
+                                          int back,
+                                          int roundUp) {
+  mpq_t k, odds;
+
+  mpq_init(k);
+  mpq_init(odds);
+
+  mpq_set_d(k, 1 - commission);
+
+  // (1 - p) / p = (denominator - numerator) / numerator
+  mpq_set_ui(odds, denominator - numerator, numerator);
+  mpq_canonicalize(odds);
+
+  if (back) {
+    mpq_div(odds, odds, k);
+  } else {
+    mpq_mul(odds, odds, k);
+  }
+
+  mpz_addmul_ui(mpq_numref(odds), mpq_denref(odds), 1);
+  mpz_mul_ui(mpq_numref(odds), mpq_numref(odds), TICKS_IN_UNIT);
+
+  if (roundUp) {
+    mpz_cdiv_q(ticks, mpq_numref(odds), mpq_denref(odds));
+  } else {
+    mpz_fdiv_q(ticks, mpq_numref(odds), mpq_denref(odds));
+  }
+
+  mpq_clear(k);
+  mpq_clear(odds);
+}
+
+// Ticks far beyond the ladder may not fit in an int, so they are
+// clamped while they are still big integers.
+static int clampExactTicks(mpz_t ticks, int (*clamp)(long)) {
+  if (mpz_cmp_si(ticks, MAX_ODDS_TICKS + 1) > 0) {
+    return clamp(MAX_ODDS_TICKS + 1);
+  }
+
+  return clamp(mpz_get_si(ticks));
+}
+
+int calculateExactBackTicks(unsigned long int numerator,
+                            unsigned long int denominator,
+                            double commission) {
+  if (numerator == 0) {
+    return NO_ODDS_TICKS;
+  }
+
+  mpz_t ticks;
+
+  mpz_init(ticks);
+  calculateExactZeroPayoffTicks(ticks, numerator, denominator, commission, 1, 0);
+  mpz_add_ui(ticks, ticks, 1);
+
+  int result = clampExactTicks(ticks, clampBackTicks);
+
+  mpz_clear(ticks);
+
+  return result;
+}
+
+int calculateExactLayTicks(unsigned long int numerator,
+                           unsigned long int denominator,
+                           double commission) {
+  if (numerator == 0) {
+    return MAX_ODDS_TICKS;
+  }
+
+  mpz_t ticks;
+
+  mpz_init(ticks);
+  calculateExactZeroPayoffTicks(ticks, numerator, denominator, commission, 0, 1);
+  mpz_sub_ui(ticks, ticks, 1);
+
+  int result = clampExactTicks(ticks, clampLayTicks);
+
+  mpz_clear(ticks);
+
+  return result;
+}
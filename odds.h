@@ -0,0 +1,65 @@
+// Odds on Betfair's Exchange Hi Lo are quoted on a ladder of ticks,
+// with TICKS_IN_UNIT ticks per unit of odds.
+#define TICKS_IN_UNIT 100
+
+// The lowest and highest odds on the ladder, in ticks.
+#define MIN_ODDS_TICKS 101
+#define MAX_ODDS_TICKS 100000
+
+// The ticks returned when no odds on the ladder are profitable, so
+// that there is nothing to quote on that side.
+#define NO_ODDS_TICKS 0
+
+// The lowest odds which, if you were to back with them, would
+// guarantee positive expected value after paying `commission` on
+// winnings.
+double calculate_tightest_back_odds(double probability, double commission);
+
+// The highest odds which, if you were to lay with them, would
+// guarantee positive expected value after paying `commission` on
+// winnings.
+double calculate_tightest_lay_odds(double probability, double commission);
+
+// The above odds in ticks, kept on the ladder. Backing at higher odds
+// or laying at lower odds is more profitable still, so back ticks
+// below the ladder are raised to MIN_ODDS_TICKS and lay ticks above it
+// lowered to MAX_ODDS_TICKS. When the tightest odds are on the other
+// side of the ladder, no odds on it are profitable, and the ticks are
+// NO_ODDS_TICKS.
+int calculateTightestBackTicks(double probability, double commission);
+
+int calculateTightestLayTicks(double probability, double commission);
+
+// The above ticks for a probability known only to be within `error`
+// of `probability`. If the ticks are the same for every probability in
+// that range, set `ticks` to them and return 1. Otherwise return 0.
+int calculateBoundedBackTicks(double probability, double error, double commission, int* ticks);
+
+int calculateBoundedLayTicks(double probability, double error, double commission, int* ticks);
+
+// The above ticks computed exactly for the probability
+// numerator / denominator.
+int calculateExactBackTicks(unsigned long int numerator,
+                            unsigned long int denominator,
+                            double commission);
+
+int calculateExactLayTicks(unsigned long int numerator,
+                           unsigned long int denominator,
+                           double commission);
+
+// The expected profit of backing or laying a stake of 1 at the given
+// odds in ticks, after paying `commission` on winnings.
+double calculateBackExpectedValue(double probability, int ticks, double commission);
+
+double calculateLayExpectedValue(double probability, int ticks, double commission);
+
+// Model the best prices available to us on the ladder, assuming the
+// market is made by participants paying `marketCommission`, who quote
+// `offsetTicks` ticks wider than their tightest profitable odds. We
+// can back at the odds they lay at, and lay at the odds they back at.
+// A side they would not quote is NO_ODDS_TICKS.
+void modelMarketTicks(double probability,
+                      double marketCommission,
+                      int offsetTicks,
+                      int* backTicks,
+                      int* layTicks);
@@ -0,0 +1,109 @@
+// Counting the ways to deal cards with every prediction correct, as
+// the exact engines in prob128.c, sized.c and stream.c do, in
+// whichever kind of number each of them needs.
+//
+// Let paths[j] be the number of ways to deal the cards so far with
+// every prediction correct, ending in the state with j cards lower
+// than the last card. A deal from the state (m, i) leads to the state
+// (m - 1, j), and is predicted correctly when the computer predicts
+// higher and j >= i, or predicts lower and j < i (see
+// isCorrectPrediction in state.h). The computer predicts higher from
+// the states with i below getHigherPredictionLimit(m), so after the
+// next deal
+//
+// next[j] = sum of paths[i] for i < min(j + 1, limit)
+//         + sum of paths[i] for i >= max(j + 1, limit),
+//
+// both of which are differences of prefix sums. The outcome at index
+// n is that the next (n + 1) deals are predicted correctly, whose
+// probability is the sum of the paths after (n + 1) deals over the
+// number of ways to deal (n + 1) cards.
+//
+// No count is more than the number of ways to deal the cards so far,
+// so a kind of number which holds that holds every count.
+
+// The range of states, [0, higherEnd) and [lowerStart, size], from
+// which a deal leading to (size - 1, position) is predicted correctly,
+// for `limit` = getHigherPredictionLimit(size).
+#define GET_CORRECT_SOURCES(position, limit, higherEnd, lowerStart) \
+  do {                                                              \
+    higherEnd = (position) + 1 < (limit) ? (position) + 1 : (limit);  \
+    lowerStart = (position) + 1 > (limit) ? (position) + 1 : (limit); \
+  } while (0)
+
+// Define a function NAME which advances `paths`, of type TYPE, over the
+// states with `size` cards left by one deal, and returns the sum of
+// the new paths. `paths` has (size + 1) values and `prefixSums` room
+// for (size + 2). The function is inlined, so that a caller which
+// knows `size` at compile time gets the loops unrolled. It needs
+// state.h.
+#define DEFINE_PATH_DEAL(NAME, TYPE)                                    \
+  static inline TYPE NAME(TYPE* paths, TYPE* prefixSums, int size) {   \
+    int limit = getHigherPredictionLimit(size);                         \
+    TYPE sum = 0;                                                       \
+                                                                        \
+    prefixSums[0] = 0;                                                  \
+                                                                        \
+    _Pragma("GCC unroll 32")                                            \
+    for (int i = 0; i <= size; i++) {                                   \
+      prefixSums[i + 1] = prefixSums[i] + paths[i];                     \
+    }                                                                   \
+                                                                        \
+    _Pragma("GCC unroll 32")                                            \
+    for (int j = 0; j < size; j++) {                                    \
+      int higherEnd;                                                    \
+      int lowerStart;                                                   \
+                                                                        \
+      GET_CORRECT_SOURCES(j, limit, higherEnd, lowerStart);             \
+      paths[j] = prefixSums[higherEnd] + (prefixSums[size + 1] - prefixSums[lowerStart]); \
+      sum += paths[j];                                                  \
+    }                                                                   \
+                                                                        \
+    paths[size] = 0;                                                    \
+                                                                        \
+    return sum;                                                         \
+  }
+
+// Define a binary GCD NAME of integers of the unsigned type TYPE, whose
+// trailing zeros COUNT_TRAILING_ZEROS counts. It takes shifts and
+// subtractions rather than the divisions of Euclid's algorithm, and is
+// several times faster for counts of this size.
+#define DEFINE_GREATEST_COMMON_DIVISOR(NAME, TYPE, COUNT_TRAILING_ZEROS) \
+  static inline TYPE NAME(TYPE a, TYPE b) {                             \
+    if (a == 0) {                                                       \
+      return b;                                                         \
+    }                                                                   \
+                                                                        \
+    int shift = COUNT_TRAILING_ZEROS(a | b);                            \
+                                                                        \
+    a >>= COUNT_TRAILING_ZEROS(a);                                      \
+                                                                        \
+    while (b != 0) {                                                    \
+      b >>= COUNT_TRAILING_ZEROS(b);                                    \
+                                                                        \
+      if (a > b) {                                                      \
+        TYPE swap = a;                                                  \
+                                                                        \
+        a = b;                                                          \
+        b = swap;                                                       \
+      }                                                                 \
+                                                                        \
+      b -= a;                                                           \
+    }                                                                   \
+                                                                        \
+    return a << shift;                                                  \
+  }
+
+DEFINE_GREATEST_COMMON_DIVISOR(getGreatestCommonDivisor, unsigned long int, __builtin_ctzl)
+
+// Set the probability count / numberDeals in lowest terms. Used by
+// sized.c and spec.c.
+static inline void reducePathCount(unsigned long int* numerator,
+                                   unsigned long int* denominator,
+                                   unsigned long int count,
+                                   unsigned long int numberDeals) {
+  unsigned long int divisor = getGreatestCommonDivisor(count, numberDeals);
+
+  *numerator = count / divisor;
+  *denominator = numberDeals / divisor;
+}
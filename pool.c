@@ -0,0 +1,261 @@
+#include <stdlib.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include "pool.h"
+
+// Each queue is a growable ring buffer protected by its own mutex, so
+// that workers only contend with each other when stealing. The owner
+// takes tasks from the back of its queue, which keeps the tasks it
+// submitted to itself hot in its cache, and thieves take them from the
+// front.
+//
+// Idle workers sleep on a condition variable until the number of
+// queued tasks becomes non zero. The number of pending tasks, queued
+// or running, lets `waitForWork` sleep until all of them have
+// finished.
+
+struct workQueue {
+  pthread_mutex_t mutex;
+  struct workTask* tasks;
+  int capacity;
+  int head;
+  int count;
+};
+
+struct workerContext {
+  struct workPool* pool;
+  int worker;
+};
+
+struct workPool {
+  int numberWorkers;
+  void (*start)(void* argument, int worker);
+  void* startArgument;
+  pthread_t* threads;
+  struct workerContext* contexts;
+  struct workQueue* queues;
+  pthread_mutex_t mutex;
+  pthread_cond_t workAvailable;
+  pthread_cond_t workDone;
+  atomic_int queued;
+  atomic_int pending;
+  int stopping;
+};
+
+#define INITIAL_QUEUE_CAPACITY 64
+
+int getNumberProcessors(void) {
+  long number = sysconf(_SC_NPROCESSORS_ONLN);
+
+  return number > 0 ? number : 1;
+}
+
+static void initialiseQueue(struct workQueue* queue) {
+  pthread_mutex_init(&queue->mutex, NULL);
+  queue->tasks = calloc(INITIAL_QUEUE_CAPACITY, sizeof(struct workTask));
+  queue->capacity = INITIAL_QUEUE_CAPACITY;
+  queue->head = 0;
+  queue->count = 0;
+}
+
+static void clearQueue(struct workQueue* queue) {
+  pthread_mutex_destroy(&queue->mutex);
+  free(queue->tasks);
+}
+
+// Double the capacity of a full queue, unwrapping the ring buffer.
+static void growQueue(struct workQueue* queue) {
+  struct workTask* tasks = calloc(2 * queue->capacity, sizeof(struct workTask));
+
+  for (int i = 0; i < queue->count; i++) {
+    tasks[i] = queue->tasks[(queue->head + i) % queue->capacity];
+  }
+
+  free(queue->tasks);
+  queue->tasks = tasks;
+  queue->capacity *= 2;
+  queue->head = 0;
+}
+
+static void pushBack(struct workQueue* queue, struct workTask task) {
+  pthread_mutex_lock(&queue->mutex);
+
+  if (queue->count == queue->capacity) {
+    growQueue(queue);
+  }
+
+  queue->tasks[(queue->head + queue->count) % queue->capacity] = task;
+  queue->count++;
+
+  pthread_mutex_unlock(&queue->mutex);
+}
+
+static int popBack(struct workQueue* queue, struct workTask* task) {
+  int found = 0;
+
+  pthread_mutex_lock(&queue->mutex);
+
+  if (queue->count > 0) {
+    queue->count--;
+    *task = queue->tasks[(queue->head + queue->count) % queue->capacity];
+    found = 1;
+  }
+
+  pthread_mutex_unlock(&queue->mutex);
+
+  return found;
+}
+
+static int popFront(struct workQueue* queue, struct workTask* task) {
+  int found = 0;
+
+  pthread_mutex_lock(&queue->mutex);
+
+  if (queue->count > 0) {
+    *task = queue->tasks[queue->head];
+    queue->head = (queue->head + 1) % queue->capacity;
+    queue->count--;
+    found = 1;
+  }
+
+  pthread_mutex_unlock(&queue->mutex);
+
+  return found;
+}
+
+// Take a task from the worker's own queue, or steal one from the other
+// workers, starting with the next one along.
+static int takeTask(struct workPool* pool, int worker, struct workTask* task) {
+  if (popBack(&pool->queues[worker], task)) {
+    return 1;
+  }
+
+  for (int i = 1; i < pool->numberWorkers; i++) {
+    if (popFront(&pool->queues[(worker + i) % pool->numberWorkers], task)) {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+static void* runWorker(void* argument) {
+  struct workerContext* context = argument;
+  struct workPool* pool = context->pool;
+  struct workTask task;
+
+  if (pool->start != NULL) {
+    pool->start(pool->startArgument, context->worker);
+  }
+
+  for (;;) {
+    if (takeTask(pool, context->worker, &task)) {
+      atomic_fetch_sub(&pool->queued, 1);
+      task.function(task.argument, context->worker);
+
+      if (atomic_fetch_sub(&pool->pending, 1) == 1) {
+        pthread_mutex_lock(&pool->mutex);
+        pthread_cond_broadcast(&pool->workDone);
+        pthread_mutex_unlock(&pool->mutex);
+      }
+
+      continue;
+    }
+
+    pthread_mutex_lock(&pool->mutex);
+
+    while (atomic_load(&pool->queued) == 0 && !pool->stopping) {
+      pthread_cond_wait(&pool->workAvailable, &pool->mutex);
+    }
+
+    int stopping = pool->stopping && atomic_load(&pool->queued) == 0;
+
+    pthread_mutex_unlock(&pool->mutex);
+
+    if (stopping) {
+      return NULL;
+    }
+  }
+}
+
+struct workPool* createWorkPool(int numberWorkers) {
+  return createStartedWorkPool(numberWorkers, NULL, NULL);
+}
+
+struct workPool* createStartedWorkPool(int numberWorkers,
+                                       void (*start)(void* argument, int worker),
+                                       void* startArgument) {
+  struct workPool* pool = malloc(sizeof(struct workPool));
+
+  pool->numberWorkers = numberWorkers;
+  pool->start = start;
+  pool->startArgument = startArgument;
+  pool->threads = calloc(numberWorkers, sizeof(pthread_t));
+  pool->contexts = calloc(numberWorkers, sizeof(struct workerContext));
+  pool->queues = calloc(numberWorkers, sizeof(struct workQueue));
+  pthread_mutex_init(&pool->mutex, NULL);
+  pthread_cond_init(&pool->workAvailable, NULL);
+  pthread_cond_init(&pool->workDone, NULL);
+  atomic_init(&pool->queued, 0);
+  atomic_init(&pool->pending, 0);
+  pool->stopping = 0;
+
+  for (int i = 0; i < numberWorkers; i++) {
+    initialiseQueue(&pool->queues[i]);
+  }
+
+  for (int i = 0; i < numberWorkers; i++) {
+    pool->contexts[i].pool = pool;
+    pool->contexts[i].worker = i;
+    pthread_create(&pool->threads[i], NULL, runWorker, &pool->contexts[i]);
+  }
+
+  return pool;
+}
+
+void freeWorkPool(struct workPool* pool) {
+  pthread_mutex_lock(&pool->mutex);
+  pool->stopping = 1;
+  pthread_cond_broadcast(&pool->workAvailable);
+  pthread_mutex_unlock(&pool->mutex);
+
+  for (int i = 0; i < pool->numberWorkers; i++) {
+    pthread_join(pool->threads[i], NULL);
+    clearQueue(&pool->queues[i]);
+  }
+
+  pthread_mutex_destroy(&pool->mutex);
+  pthread_cond_destroy(&pool->workAvailable);
+  pthread_cond_destroy(&pool->workDone);
+  free(pool->threads);
+  free(pool->contexts);
+  free(pool->queues);
+  free(pool);
+}
+
+int getNumberWorkers(struct workPool* pool) {
+  return pool->numberWorkers;
+}
+
+void submitWork(struct workPool* pool, int worker, void (*function)(void* argument, int worker), void* argument) {
+  struct workTask task = { function, argument };
+
+  atomic_fetch_add(&pool->pending, 1);
+  pushBack(&pool->queues[worker % pool->numberWorkers], task);
+  atomic_fetch_add(&pool->queued, 1);
+
+  pthread_mutex_lock(&pool->mutex);
+  pthread_cond_broadcast(&pool->workAvailable);
+  pthread_mutex_unlock(&pool->mutex);
+}
+
+void waitForWork(struct workPool* pool) {
+  pthread_mutex_lock(&pool->mutex);
+
+  while (atomic_load(&pool->pending) > 0) {
+    pthread_cond_wait(&pool->workDone, &pool->mutex);
+  }
+
+  pthread_mutex_unlock(&pool->mutex);
+}
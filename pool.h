@@ -0,0 +1,39 @@
+// A pool of worker threads which execute tasks. Each worker has its
+// own queue of tasks. A worker takes the most recently added task from
+// its own queue, and when that is empty, steals the oldest task from
+// the queue of another worker.
+
+struct workTask {
+  void (*function)(void* argument, int worker);
+  void* argument;
+};
+
+struct workQueue;
+
+struct workPool;
+
+struct workPool* createWorkPool(int numberWorkers);
+
+// Create a pool whose workers each first call `start` with
+// `startArgument` and their index, for example to pin themselves to
+// processors (see numa.h), before taking any tasks.
+struct workPool* createStartedWorkPool(int numberWorkers,
+                                       void (*start)(void* argument, int worker),
+                                       void* startArgument);
+
+// Stop the workers and free the pool. There must be no outstanding
+// tasks.
+void freeWorkPool(struct workPool* pool);
+
+int getNumberWorkers(struct workPool* pool);
+
+// Add a task to the queue of `worker`. The function is called with the
+// argument and the index of the worker which runs it.
+void submitWork(struct workPool* pool, int worker, void (*function)(void* argument, int worker), void* argument);
+
+// Wait until all submitted tasks have finished.
+void waitForWork(struct workPool* pool);
+
+// The number of online processors, to use as a default number of
+// workers.
+int getNumberProcessors(void);
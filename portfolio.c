@@ -0,0 +1,353 @@
+#include <stdlib.h>
+#include <math.h>
+#include "risk.h"
+#include "portfolio.h"
+
+// The games are independent, so the distribution of their total profit
+// is the convolution of the distributions of the profit on each game.
+// Convolving the games one after another takes time quadratic in the
+// number of games, because the support of the running total keeps
+// growing. Instead, we convolve the games in pairs, then the results
+// in pairs, and so on, so that each game takes part in a logarithmic
+// number of convolutions. Convolutions of long distributions are done
+// by multiplying their discrete Fourier transforms.
+//
+// The transforms are computed in floating point, and leave errors of
+// the order of the rounding error relative to the largest
+// probability. Negative probabilities caused by this are set to 0.
+
+// The rough cost of each step of a transform, relative to one multiply
+// and add of a direct convolution.
+#define TRANSFORM_STEP_COST 8
+
+static struct profitDistribution* createProfitDistribution(double gridStep,
+                                                           long firstBucket,
+                                                           int length) {
+  struct profitDistribution* distribution = malloc(sizeof(struct profitDistribution));
+
+  distribution->gridStep = gridStep;
+  distribution->firstBucket = firstBucket;
+  distribution->length = length;
+  distribution->probabilities = calloc(length, sizeof(double));
+
+  return distribution;
+}
+
+void freeProfitDistribution(struct profitDistribution* distribution) {
+  free(distribution->probabilities);
+  free(distribution);
+}
+
+struct profitDistribution* createGameDistribution(double* profits,
+                                                  double* streakProbabilities,
+                                                  int numberStreaks,
+                                                  double gridStep) {
+  long firstBucket = 0;
+  long lastBucket = 0;
+  int first = 1;
+
+  for (int i = 0; i < numberStreaks; i++) {
+    if (streakProbabilities[i] > 0) {
+      long bucket = lround(profits[i] / gridStep);
+
+      if (first || bucket < firstBucket) {
+        firstBucket = bucket;
+      }
+
+      if (first || bucket > lastBucket) {
+        lastBucket = bucket;
+      }
+
+      first = 0;
+    }
+  }
+
+  struct profitDistribution* distribution =
+    createProfitDistribution(gridStep, firstBucket, lastBucket - firstBucket + 1);
+
+  for (int i = 0; i < numberStreaks; i++) {
+    if (streakProbabilities[i] > 0) {
+      long bucket = lround(profits[i] / gridStep);
+
+      distribution->probabilities[bucket - firstBucket] += streakProbabilities[i];
+    }
+  }
+
+  return distribution;
+}
+
+// An in place iterative radix 2 fast Fourier transform of the complex
+// values with real parts `re` and imaginary parts `im`. `length` must
+// be a power of 2. The inverse transform is not scaled. The complex
+// arithmetic is written out, as the C99 complex multiplication checks
+// for infinities and is several times slower.
+static void transform(double* re, double* im, int length, int inverse) {
+  for (int i = 1, j = 0; i < length; i++) {
+    int bit = length >> 1;
+
+    for (; j & bit; bit >>= 1) {
+      j ^= bit;
+    }
+
+    j ^= bit;
+
+    if (i < j) {
+      double swapRe = re[i];
+      double swapIm = im[i];
+
+      re[i] = re[j];
+      im[i] = im[j];
+      re[j] = swapRe;
+      im[j] = swapIm;
+    }
+  }
+
+  double* twiddleRe = malloc((length / 2 + 1) * sizeof(double));
+  double* twiddleIm = malloc((length / 2 + 1) * sizeof(double));
+
+  for (int i = 0; i < length / 2; i++) {
+    double angle = (inverse ? 2 : -2) * M_PI * i / length;
+
+    twiddleRe[i] = cos(angle);
+    twiddleIm[i] = sin(angle);
+  }
+
+  for (int width = 2; width <= length; width <<= 1) {
+    int half = width / 2;
+    int stride = length / width;
+
+    for (int start = 0; start < length; start += width) {
+      for (int i = 0; i < half; i++) {
+        double wRe = twiddleRe[i * stride];
+        double wIm = twiddleIm[i * stride];
+        int even = start + i;
+        int odd = even + half;
+        double oddRe = re[odd] * wRe - im[odd] * wIm;
+        double oddIm = re[odd] * wIm + im[odd] * wRe;
+
+        re[odd] = re[even] - oddRe;
+        im[odd] = im[even] - oddIm;
+        re[even] += oddRe;
+        im[even] += oddIm;
+      }
+    }
+  }
+
+  free(twiddleRe);
+  free(twiddleIm);
+}
+
+// The distribution of a single game has at most one bucket for each
+// streak length, so most of its buckets are empty. Skipping them makes
+// direct convolution the faster choice at the first levels.
+static void convolveDirectly(double* result, double* a, int lengthA, double* b, int lengthB) {
+  for (int i = 0; i < lengthA; i++) {
+    if (a[i] == 0) {
+      continue;
+    }
+
+    for (int j = 0; j < lengthB; j++) {
+      result[i + j] += a[i] * b[j];
+    }
+  }
+}
+
+// Pack a into the real parts and b into the imaginary parts, so that
+// one forward transform serves both. With z the transform of the
+// packed values, and z' the conjugate of z at the mirrored index, the
+// transforms of a and b are (z + z') / 2 and (z - z') / 2i. Their
+// product is (z^2 - z'^2) / 4i.
+static void convolveByTransform(double* result, double* a, int lengthA, double* b, int lengthB) {
+  int resultLength = lengthA + lengthB - 1;
+  int length = 1;
+
+  while (length < resultLength) {
+    length <<= 1;
+  }
+
+  double* re = calloc(length, sizeof(double));
+  double* im = calloc(length, sizeof(double));
+  double* productRe = calloc(length, sizeof(double));
+  double* productIm = calloc(length, sizeof(double));
+
+  for (int i = 0; i < lengthA; i++) {
+    re[i] = a[i];
+  }
+
+  for (int i = 0; i < lengthB; i++) {
+    im[i] = b[i];
+  }
+
+  transform(re, im, length, 0);
+
+  for (int i = 0; i < length; i++) {
+    int mirror = (length - i) & (length - 1);
+    double zRe = re[i];
+    double zIm = im[i];
+    double mirrorRe = re[mirror];
+    double mirrorIm = -im[mirror];
+    double differenceRe = (zRe * zRe - zIm * zIm) - (mirrorRe * mirrorRe - mirrorIm * mirrorIm);
+    double differenceIm = 2 * (zRe * zIm - mirrorRe * mirrorIm);
+
+    productRe[i] = differenceIm / 4;
+    productIm[i] = -differenceRe / 4;
+  }
+
+  transform(productRe, productIm, length, 1);
+
+  for (int i = 0; i < resultLength; i++) {
+    double probability = productRe[i] / length;
+
+    result[i] = probability > 0 ? probability : 0;
+  }
+
+  free(re);
+  free(im);
+  free(productRe);
+  free(productIm);
+}
+
+static int countNonZero(struct profitDistribution* distribution) {
+  int count = 0;
+
+  for (int i = 0; i < distribution->length; i++) {
+    count += distribution->probabilities[i] != 0;
+  }
+
+  return count;
+}
+
+// Is convolving directly expected to be cheaper than by transform?
+static int isDirectConvolutionCheaper(struct profitDistribution* a, struct profitDistribution* b) {
+  long length = 1;
+  long logLength = 0;
+
+  while (length < a->length + b->length - 1) {
+    length <<= 1;
+    logLength++;
+  }
+
+  return (long) countNonZero(a) * b->length < TRANSFORM_STEP_COST * length * (logLength + 1);
+}
+
+static struct profitDistribution* convolvePair(struct profitDistribution* a,
+                                               struct profitDistribution* b) {
+  struct profitDistribution* result = createProfitDistribution(a->gridStep,
+                                                               a->firstBucket + b->firstBucket,
+                                                               a->length + b->length - 1);
+
+  if (isDirectConvolutionCheaper(a, b)) {
+    convolveDirectly(result->probabilities, a->probabilities, a->length, b->probabilities, b->length);
+  } else {
+    convolveByTransform(result->probabilities, a->probabilities, a->length, b->probabilities, b->length);
+  }
+
+  return result;
+}
+
+struct profitDistribution* convolveDistributions(struct profitDistribution** distributions,
+                                                 int numberDistributions) {
+  struct profitDistribution** level = calloc(numberDistributions, sizeof(struct profitDistribution*));
+  int numberLevel = numberDistributions;
+
+  // Copy the first level, so that every distribution in `level` can be
+  // freed once it has been convolved.
+  for (int i = 0; i < numberDistributions; i++) {
+    struct profitDistribution* distribution = distributions[i];
+
+    level[i] = createProfitDistribution(distribution->gridStep,
+                                        distribution->firstBucket,
+                                        distribution->length);
+
+    for (int j = 0; j < distribution->length; j++) {
+      level[i]->probabilities[j] = distribution->probabilities[j];
+    }
+  }
+
+  while (numberLevel > 1) {
+    int numberNext = 0;
+
+    for (int i = 0; i < numberLevel; i += 2) {
+      if (i + 1 < numberLevel) {
+        struct profitDistribution* pair = convolvePair(level[i], level[i + 1]);
+
+        freeProfitDistribution(level[i]);
+        freeProfitDistribution(level[i + 1]);
+        level[numberNext++] = pair;
+      } else {
+        level[numberNext++] = level[i];
+      }
+    }
+
+    numberLevel = numberNext;
+  }
+
+  struct profitDistribution* result = level[0];
+
+  free(level);
+
+  return result;
+}
+
+// Slots with no game started have nothing to add. The distributions
+// start with a certain profit of 0, which leaves the convolution
+// unchanged, so that a portfolio with no games has that distribution.
+struct profitDistribution* calculatePortfolioDistribution(struct riskEngine* engine,
+                                                          double gridStep) {
+  struct profitDistribution** distributions =
+    calloc(engine->numberGames + 1, sizeof(struct profitDistribution*));
+  int numberDistributions = 1;
+
+  distributions[0] = createProfitDistribution(gridStep, 0, 1);
+  distributions[0]->probabilities[0] = 1;
+
+  for (int game = 0; game < engine->numberGames; game++) {
+    if (engine->games[game].startSize == 0) {
+      continue;
+    }
+
+    distributions[numberDistributions++] =
+      createGameDistribution(&engine->profits[game * engine->maxSize],
+                             &engine->streakProbabilities[game * engine->maxSize],
+                             engine->games[game].startSize,
+                             gridStep);
+  }
+
+  struct profitDistribution* result = convolveDistributions(distributions, numberDistributions);
+
+  for (int i = 0; i < numberDistributions; i++) {
+    freeProfitDistribution(distributions[i]);
+  }
+
+  free(distributions);
+
+  return result;
+}
+
+double calculateRuinProbability(struct profitDistribution* distribution, double bankroll) {
+  double sum = 0;
+
+  for (int i = 0; i < distribution->length; i++) {
+    double profit = (distribution->firstBucket + i) * distribution->gridStep;
+
+    if (bankroll + profit <= 0) {
+      sum += distribution->probabilities[i];
+    }
+  }
+
+  return sum;
+}
+
+double calculateValueAtRisk(struct profitDistribution* distribution, double level) {
+  double sum = 0;
+
+  for (int i = 0; i < distribution->length; i++) {
+    sum += distribution->probabilities[i];
+
+    if (sum >= 1 - level) {
+      return -(distribution->firstBucket + i) * distribution->gridStep;
+    }
+  }
+
+  return -(distribution->firstBucket + distribution->length - 1) * distribution->gridStep;
+}
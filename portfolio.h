@@ -0,0 +1,39 @@
+// The distribution of profit, bucketed to multiples of `gridStep`.
+// probabilities[i] is the probability of a profit of
+// (firstBucket + i) * gridStep.
+struct profitDistribution {
+  double gridStep;
+  long firstBucket;
+  int length;
+  double* probabilities;
+};
+
+void freeProfitDistribution(struct profitDistribution* distribution);
+
+// The distribution of profit on one game, where the profit for a final
+// streak of length i is profits[i], and the probability of that
+// streak is streakProbabilities[i], for 0 <= i < numberStreaks.
+struct profitDistribution* createGameDistribution(double* profits,
+                                                  double* streakProbabilities,
+                                                  int numberStreaks,
+                                                  double gridStep);
+
+// The distribution of the total profit over independent games. All
+// distributions must have the same `gridStep`, and there must be at
+// least one.
+struct profitDistribution* convolveDistributions(struct profitDistribution** distributions,
+                                                 int numberDistributions);
+
+// The distribution of the total profit over all games started on a
+// risk engine (see risk.h).
+struct riskEngine;
+
+struct profitDistribution* calculatePortfolioDistribution(struct riskEngine* engine,
+                                                          double gridStep);
+
+// The probability of losing at least the whole of `bankroll`.
+double calculateRuinProbability(struct profitDistribution* distribution, double bankroll);
+
+// The smallest loss which is exceeded with a probability of at most
+// (1 - level), e.g. for level 0.99.
+double calculateValueAtRisk(struct profitDistribution* distribution, double level);
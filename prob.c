@@ -1,4 +1,5 @@
 #include <stdlib.h>
+#include <float.h>
 #include "prob.h"
 #include "gmp.h"
 
@@ -109,25 +110,20 @@ static int** createMatrix(int size) {
   return matrix;
 }
 
+static void freeMatrix(int** matrix, int size) {
+  for (int i = 0; i < size - 1; i++) {
+    free(matrix[i]);
+  }
+
+  free(matrix);
+}
+
 // Given a deck of `size` remaining cards, there are (size - 1)
 // outcomes which are interesting to us.
 int getLengthOfProbabilities(int size) {
   return size - 1;
 }
 
-// Create an array to hold the probabilities which we are interested
-// in computing.
-static mpq_t* createProbabilities(int size) {
-  int lengthOfProbabilities = getLengthOfProbabilities(size);
-  mpq_t* probabilities = calloc(lengthOfProbabilities, sizeof(mpq_t));
-
-  for (int i = 0; i < lengthOfProbabilities; i++) {
-    mpq_init(probabilities[i]);
-  }
-
-  return probabilities;
-}
-
 // Create a container to hold either the numerators or denominators of
 // the calculated probabilities.
 unsigned long int* createProbabilitiesResult(int size) {
@@ -307,14 +303,18 @@ static void initialiseStage(int** matrix, int size, int stage) {
 
 // To calculate the whole matrix, initialise the first stage, and
 // compute each following stage successively.
-static void calculateMatrix(int** matrix, int size, int numberPlayable) {
+static void calculateMatrixUntil(int** matrix, int size, int numberPlayable, int lastStage) {
   initialiseFirstStage(matrix, size, numberPlayable);
 
-  for (int i = 1; i < size - 1; i++) {
+  for (int i = 1; i <= lastStage; i++) {
     initialiseStage(matrix, size, i);
   }
 }
 
+static void calculateMatrix(int** matrix, int size, int numberPlayable) {
+  calculateMatrixUntil(matrix, size, numberPlayable, size - 2);
+}
+
 // See the documentation for calculatePermutations to understand what
 // permutations is.
 static int getLengthOfPermutations(int size) {
@@ -322,10 +322,15 @@ static int getLengthOfPermutations(int size) {
 }
 
 // The number of ways to deal `size - 1` cards from a deck of size
-// `size`.
+// `size`. With two cards there are no permutations of two or more
+// cards to look up, and one card can be dealt in `size` ways.
 static long getNumberShuffles(long* permutations, int size) {
   int lengthOfPermutations = getLengthOfPermutations(size);
 
+  if (lengthOfPermutations == 0) {
+    return size;
+  }
+
   return permutations[lengthOfPermutations - 1];
 }
 
@@ -338,6 +343,19 @@ static int numberFailingCards(int numberCardsLeft, int numberLower) {
   return numberHigher >= numberLower ? numberLower : numberHigher;
 }
 
+// How many ways are there to successfully predict each card up to and
+// including Card n, and then play a failing card after?
+static long countFailingPaths(int** matrix, int size, int n) {
+  int numberCardsLeft = size - n;
+  long sum = 0;
+
+  for (int numberLower = 0; numberLower < numberCardsLeft; numberLower++) {
+    sum += matrix[n][numberLower] * numberFailingCards(numberCardsLeft, numberLower);
+  }
+
+  return sum;
+}
+
 // We now calculate the probabilities of the outcomes mentioned in the
 // outline, based on the populated matrix. As described before, we are
 // interested in the probabilities of the outcomes of the form: <Card
@@ -385,105 +403,83 @@ static int numberFailingCards(int numberCardsLeft, int numberLower) {
 // We calculate the appropriate sums of the independent probabilities
 // in `accumulateProbabilities`, which gives us our final result.
 static void calculateInitialProbabilities(int** matrix,
-                                         mpq_t* probabilities,
+                                         long* counts,
                                          long* permutations,
                                          int size) {
-  for (int n = 0; n < size - 2; n++) {
-    int numberCardsLeft = size - n;
-    long sum = 0;
+  long numberShuffles = getNumberShuffles(permutations, size);
 
-    for (int numberLower = 0; numberLower < numberCardsLeft; numberLower++) {
-      // How many ways are there to successfully predict each card up
-      // to and including Card n, and then play a failing card after?
-      sum += matrix[n][numberLower] * numberFailingCards(numberCardsLeft, numberLower);
-    }
+  for (int n = 0; n < size - 2; n++) {
+    long sum = countFailingPaths(matrix, size, n);
 
-    // This sets probabilities[n] to (sum / permutations[n]), where
+    // The probability is (sum / permutations[n]), where
     // permutations[n] is the number of ways to deal (n + 2) cards
     // from a deck of size `size`. This is because after dealing the
     // card at stage n and then dealing a failing card, we have dealt
-    // (n + 2) cards.
-    mpq_set_si(probabilities[n], sum, permutations[n]);
-    mpq_canonicalize(probabilities[n]);
+    // (n + 2) cards. Each of those deals can be completed in the same
+    // number of ways to a deal of (size - 1) cards, so over
+    // `numberShuffles` the count is multiplied by that number.
+    counts[n] = sum * (numberShuffles / permutations[n]);
   }
 }
 
 // See documentation for `calculateInitialProbabilities`
-static void calculateFinalProbability(int** matrix,
-                                      mpq_t* probabilities,
-                                      long* permutations,
-                                      int size) {
+static void calculateFinalProbability(int** matrix, long* counts, int size) {
   int lengthOfProbabilities = getLengthOfProbabilities(size);
 
   // After dealing the penultimate card in stage (size - 2), the one
   // remaining card is either higher or lower than the card dealt. Sum
   // over the values matrix[size - 2][0] and matrix[size - 2][1] to
-  // encapsulate both cases.
-  long sum = matrix[size - 2][0] + matrix[size - 2][1];
-
-  // The number of ways to deal `size - 1` cards from a deck of size `size`.
-  long numberShuffles = getNumberShuffles(permutations, size);
-
-  // This sets probabilities[n] to (sum / numberShuffles).
-  mpq_set_si(probabilities[lengthOfProbabilities - 1], sum, numberShuffles);
-  mpq_canonicalize(probabilities[lengthOfProbabilities - 1]);
+  // encapsulate both cases. This is already a count of deals of
+  // (size - 1) cards.
+  counts[lengthOfProbabilities - 1] = matrix[size - 2][0] + matrix[size - 2][1];
 }
 
-// See documentation for `calculateInitialProbabilities` These are the
-// rational probabilities calculated internally. This programme
-// returns the probabilities split into their numerators and
-// denominators to the outside world.
+// See documentation for `calculateInitialProbabilities`. Rather than
+// rational probabilities, which would each need reducing, we count
+// every outcome over the same denominator, the number of ways to deal
+// `size - 1` cards from a deck of size `size`. Every other
+// denominator divides it, so the counts are exact integers, and
+// summing them needs no greatest common divisors.
 static void calculateInternalProbabilities(int** matrix,
-                                           mpq_t* probabilities,
+                                           long* counts,
                                            long* permutations,
                                            int size) {
-  calculateInitialProbabilities(matrix, probabilities, permutations, size);
-  calculateFinalProbability(matrix, probabilities, permutations, size);
+  calculateInitialProbabilities(matrix, counts, permutations, size);
+  calculateFinalProbability(matrix, counts, size);
 }
 
 // See documentation for `calculateInitialProbabilities`
-static void accumulateProbabilities(mpq_t* probabilities, int size) {
-  mpq_t sum, oldProbability;
+static void accumulateProbabilities(long* counts, int size) {
+  long sum = 0;
   int lengthOfProbabilities = getLengthOfProbabilities(size);
 
-  mpq_init(sum);
-  mpq_init(oldProbability);
-
   for (int n = lengthOfProbabilities - 1; n >= 0; n--) {
-    mpq_set(oldProbability, probabilities[n]);
-
-    mpq_add(probabilities[n], probabilities[n], sum);
-    mpq_add(sum, sum, oldProbability);
+    sum += counts[n];
+    counts[n] = sum;
   }
-
-  mpq_clear(sum);
-  mpq_clear(oldProbability);
 }
 
-// Unzip the mpq_t probabilities into their numerators and denominators.
+// Reduce each count over `numberShuffles` to lowest terms, once, and
+// unzip it into its numerator and denominator.
 static void convertToNumeratorsAndDenominators(unsigned long int* numeratorsResult,
                                                unsigned long int* denominatorsResult,
-                                               mpq_t* probabilities,
+                                               long* counts,
+                                               long numberShuffles,
                                                int size) {
   int lengthOfProbabilities = getLengthOfProbabilities(size);
+  mpq_t probability;
 
-  for (int i = 0; i < lengthOfProbabilities; i++) {
-    unsigned long int numerator = mpz_get_ui(mpq_numref(probabilities[i]));
-    unsigned long int denominator = mpz_get_ui(mpq_denref(probabilities[i]));
-
-    numeratorsResult[i] = numerator;
-    denominatorsResult[i] = denominator;
-  }
-}
-
-static void freeProbabilities(mpq_t* probabilities, int size) {
-  int lengthOfProbabilities = getLengthOfProbabilities(size);
+  mpq_init(probability);
 
   for (int i = 0; i < lengthOfProbabilities; i++) {
-    mpq_clear(probabilities[i]);
+    mpq_set_si(probability, counts[i], numberShuffles);
+    mpq_canonicalize(probability);
+
+    numeratorsResult[i] = mpz_get_ui(mpq_numref(probability));
+    denominatorsResult[i] = mpz_get_ui(mpq_denref(probability));
   }
 
-  free(probabilities);
+  mpq_clear(probability);
 }
 
 // See documentation for calculatePermutations.
@@ -505,24 +501,116 @@ static void calculatePermutations(long* permutations, int size) {
   }
 }
 
+// See documentation for `calculateInternalProbabilities`.
+static long* createCounts(int size) {
+  return calloc(getLengthOfProbabilities(size), sizeof(long));
+}
+
 void calculateProbabilities(unsigned long int* numeratorsResult,
                             unsigned long int* denominatorsResult,
                             int size,
                             int numberLower) {
   int** matrix = createMatrix(size);
-  mpq_t* probabilities = createProbabilities(size);
+  long* counts = createCounts(size);
   long* permutations = createPermutations(size);
 
   calculateMatrix(matrix, size, numberLower);
   calculatePermutations(permutations, size);
-  calculateInternalProbabilities(matrix, probabilities, permutations, size);
-  accumulateProbabilities(probabilities, size);
+  calculateInternalProbabilities(matrix, counts, permutations, size);
+  accumulateProbabilities(counts, size);
   convertToNumeratorsAndDenominators(numeratorsResult,
                                      denominatorsResult,
-                                     probabilities,
+                                     counts,
+                                     getNumberShuffles(permutations, size),
                                      size);
 
-  free(matrix);
-  freeProbabilities(probabilities, size);
+  freeMatrix(matrix, size);
+  free(counts);
+  free(permutations);
+}
+
+// The same probabilities in double precision, without any rational
+// arithmetic. The counts over the common denominator are exact, so
+// the only rounding is in converting each count and the number of
+// shuffles to double and dividing them. Each of these three
+// operations has a relative error of at most half of DBL_EPSILON,
+// which bounds the error of each probability as below.
+void calculateProbabilitiesApproximately(double* probabilitiesResult,
+                                         double* errorsResult,
+                                         int size,
+                                         int numberLower) {
+  int lengthOfProbabilities = getLengthOfProbabilities(size);
+  int** matrix = createMatrix(size);
+  long* counts = createCounts(size);
+  long* permutations = createPermutations(size);
+
+  calculateMatrix(matrix, size, numberLower);
+  calculatePermutations(permutations, size);
+  calculateInternalProbabilities(matrix, counts, permutations, size);
+  accumulateProbabilities(counts, size);
+
+  long numberShuffles = getNumberShuffles(permutations, size);
+
+  for (int n = 0; n < lengthOfProbabilities; n++) {
+    probabilitiesResult[n] = (double) counts[n] / (double) numberShuffles;
+    errorsResult[n] = probabilitiesResult[n] * 2 * DBL_EPSILON;
+  }
+
+  freeMatrix(matrix, size);
+  free(counts);
   free(permutations);
 }
+
+// Often only a few outcomes are wanted. The value matrix[n][i] counts
+// the ways to deal the (n + 1) cards up to and including stage n with
+// every prediction correct, so the outcome at index n, that the next
+// (n + 1) deals are predicted correctly, is the sum of row n over the
+// number of ways to deal (n + 1) cards. This needs neither the
+// independent probabilities nor their accumulation, and the matrix
+// only up to the row of the last outcome wanted.
+int calculateSelectedProbabilities(unsigned long int* numeratorsResult,
+                                   unsigned long int* denominatorsResult,
+                                   int* outcomes,
+                                   int numberOutcomes,
+                                   int size,
+                                   int numberLower) {
+  int lastStage = 0;
+
+  for (int i = 0; i < numberOutcomes; i++) {
+    if (outcomes[i] < 0 || outcomes[i] >= getLengthOfProbabilities(size)) {
+      return 0;
+    }
+
+    lastStage = outcomes[i] > lastStage ? outcomes[i] : lastStage;
+  }
+
+  int** matrix = createMatrix(size);
+  long* permutations = createPermutations(size);
+  mpq_t probability;
+
+  mpq_init(probability);
+  calculateMatrixUntil(matrix, size, numberLower, lastStage);
+  calculatePermutations(permutations, size);
+
+  for (int i = 0; i < numberOutcomes; i++) {
+    int n = outcomes[i];
+    long sum = 0;
+
+    for (int j = 0; j < size - n; j++) {
+      sum += matrix[n][j];
+    }
+
+    // permutations[n - 1] is the number of ways to deal (n + 1) cards.
+    mpq_set_si(probability, sum, n == 0 ? size : permutations[n - 1]);
+    mpq_canonicalize(probability);
+
+    numeratorsResult[i] = mpz_get_ui(mpq_numref(probability));
+    denominatorsResult[i] = mpz_get_ui(mpq_denref(probability));
+  }
+
+  mpq_clear(probability);
+  freeMatrix(matrix, size);
+  free(permutations);
+
+  return 1;
+}
@@ -10,3 +10,23 @@ void calculateProbabilities(unsigned long int* numeratorsResult,
                             unsigned long int* denominatorsResult,
                             int size,
                             int numberLower);
+
+// The same probabilities as `calculateProbabilities` in double
+// precision, each within the corresponding `errorsResult` of the exact
+// probability. Both results hold getLengthOfProbabilities(size)
+// values.
+void calculateProbabilitiesApproximately(double* probabilitiesResult,
+                                         double* errorsResult,
+                                         int size,
+                                         int numberLower);
+
+// The probabilities of only the outcomes at the indices `outcomes`, in
+// the same order, so that the results hold `numberOutcomes` values.
+// Returns 0, and computes nothing, if any index is not that of an
+// outcome of a deck with `size` cards.
+int calculateSelectedProbabilities(unsigned long int* numeratorsResult,
+                                   unsigned long int* denominatorsResult,
+                                   int* outcomes,
+                                   int numberOutcomes,
+                                   int size,
+                                   int numberLower);
@@ -0,0 +1,151 @@
+#include <stdlib.h>
+#include "prob.h"
+#include "prob128.h"
+#include "state.h"
+#include "paths.h"
+
+// The engine in prob.c counts the correctly predicted deals in `int`
+// and the ways to deal cards in `long`, which overflow for decks of
+// around 20 cards. This engine counts the same paths differently, so
+// that every count it needs is at most the number of ways to deal
+// the whole deck, `size`!, which fits in 128 bits up to 34 cards.
+//
+// The paths are counted as in paths.h. The engine is written once for
+// each kind of integer. The 128 bit one checks the number of ways to
+// deal for overflow, which bounds every other count, and gives up if
+// it overflows. The GMP one cannot overflow.
+
+DEFINE_PATH_DEAL(dealWide, unsigned __int128)
+
+// The trailing zeros of a nonzero 128 bit integer.
+static inline int countWideTrailingZeros(unsigned __int128 a) {
+  unsigned long int low = (unsigned long int) a;
+
+  return low != 0 ? __builtin_ctzl(low) : 64 + __builtin_ctzl((unsigned long int) (a >> 64));
+}
+
+DEFINE_GREATEST_COMMON_DIVISOR(getWideGreatestCommonDivisor, unsigned __int128, countWideTrailingZeros)
+
+int calculateWideProbabilities(unsigned __int128* numeratorsResult,
+                               unsigned __int128* denominatorsResult,
+                               int size,
+                               int numberLower) {
+  unsigned __int128* paths = calloc(size + 1, sizeof(unsigned __int128));
+  unsigned __int128* prefixSums = calloc(size + 2, sizeof(unsigned __int128));
+  unsigned __int128 numberDeals = 1;
+  int fits = 1;
+
+  paths[numberLower] = 1;
+
+  for (int n = 0; fits && n < getLengthOfProbabilities(size); n++) {
+    int m = size - n;
+
+    unsigned __int128 sum = dealWide(paths, prefixSums, m);
+
+    fits = !__builtin_mul_overflow(numberDeals, m, &numberDeals);
+
+    if (fits) {
+      unsigned __int128 divisor = getWideGreatestCommonDivisor(sum, numberDeals);
+
+      numeratorsResult[n] = sum / divisor;
+      denominatorsResult[n] = numberDeals / divisor;
+    }
+  }
+
+  free(paths);
+  free(prefixSums);
+
+  return fits;
+}
+
+static void dealLarge(mpz_t* paths, mpz_t* prefixSums, int m) {
+  int limit = getHigherPredictionLimit(m);
+
+  mpz_set_ui(prefixSums[0], 0);
+
+  for (int i = 0; i <= m; i++) {
+    mpz_add(prefixSums[i + 1], prefixSums[i], paths[i]);
+  }
+
+  for (int j = 0; j < m; j++) {
+    int higherEnd;
+    int lowerStart;
+
+    GET_CORRECT_SOURCES(j, limit, higherEnd, lowerStart);
+    mpz_sub(paths[j], prefixSums[m + 1], prefixSums[lowerStart]);
+    mpz_add(paths[j], paths[j], prefixSums[higherEnd]);
+  }
+
+  mpz_set_ui(paths[m], 0);
+}
+
+static void calculateProbabilitiesWithGmp(mpq_t* probabilitiesResult, int size, int numberLower) {
+  mpz_t* paths = calloc(size + 1, sizeof(mpz_t));
+  mpz_t* prefixSums = calloc(size + 2, sizeof(mpz_t));
+  mpz_t numberDeals;
+
+  for (int i = 0; i <= size; i++) {
+    mpz_init(paths[i]);
+  }
+
+  for (int i = 0; i <= size + 1; i++) {
+    mpz_init(prefixSums[i]);
+  }
+
+  mpz_init_set_ui(numberDeals, 1);
+  mpz_set_ui(paths[numberLower], 1);
+
+  for (int n = 0; n < getLengthOfProbabilities(size); n++) {
+    int m = size - n;
+
+    dealLarge(paths, prefixSums, m);
+    mpz_mul_ui(numberDeals, numberDeals, m);
+
+    mpz_set_ui(mpq_numref(probabilitiesResult[n]), 0);
+
+    for (int j = 0; j < m; j++) {
+      mpz_add(mpq_numref(probabilitiesResult[n]), mpq_numref(probabilitiesResult[n]), paths[j]);
+    }
+
+    mpz_set(mpq_denref(probabilitiesResult[n]), numberDeals);
+    mpq_canonicalize(probabilitiesResult[n]);
+  }
+
+  for (int i = 0; i <= size; i++) {
+    mpz_clear(paths[i]);
+  }
+
+  for (int i = 0; i <= size + 1; i++) {
+    mpz_clear(prefixSums[i]);
+  }
+
+  mpz_clear(numberDeals);
+  free(paths);
+  free(prefixSums);
+}
+
+// GMP has no conversion from 128 bit integers, so set the two 64 bit
+// halves in turn.
+static void setWide(mpz_t result, unsigned __int128 value) {
+  mpz_set_ui(result, (unsigned long int) (value >> 64));
+  mpz_mul_2exp(result, result, 64);
+  mpz_add_ui(result, result, (unsigned long int) value);
+}
+
+void calculateLargeProbabilities(mpq_t* probabilitiesResult, int size, int numberLower) {
+  int lengthOfProbabilities = getLengthOfProbabilities(size);
+  unsigned __int128* numerators = calloc(lengthOfProbabilities, sizeof(unsigned __int128));
+  unsigned __int128* denominators = calloc(lengthOfProbabilities, sizeof(unsigned __int128));
+
+  if (calculateWideProbabilities(numerators, denominators, size, numberLower)) {
+    for (int n = 0; n < lengthOfProbabilities; n++) {
+      setWide(mpq_numref(probabilitiesResult[n]), numerators[n]);
+      setWide(mpq_denref(probabilitiesResult[n]), denominators[n]);
+    }
+  } else {
+    calculateProbabilitiesWithGmp(probabilitiesResult, size, numberLower);
+  }
+
+  free(numerators);
+  free(denominators);
+}
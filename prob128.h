@@ -0,0 +1,19 @@
+#include "gmp.h"
+
+// Exact outcome probabilities for decks too large for
+// `calculateProbabilities` in prob.c, whose counts overflow beyond
+// about 20 cards. The outcomes are the same, getLengthOfProbabilities(size)
+// of them.
+
+// Count with 128 bit integers, which is exact for decks of up to 34
+// cards. Set the probabilities in lowest terms and return 1, or return
+// 0 if a count overflows.
+int calculateWideProbabilities(unsigned __int128* numeratorsResult,
+                               unsigned __int128* denominatorsResult,
+                               int size,
+                               int numberLower);
+
+// Count with 128 bit integers where they are wide enough, and with GMP
+// integers otherwise. Each of the `probabilitiesResult` must have been
+// initialised with mpq_init.
+void calculateLargeProbabilities(mpq_t* probabilitiesResult, int size, int numberLower);
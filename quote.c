@@ -0,0 +1,191 @@
+#include <stdlib.h>
+#include <math.h>
+#include "odds.h"
+#include "quote.h"
+
+// For each open outcome we quote to back at the tightest profitable
+// back odds, and to lay at the tightest profitable lay odds, after
+// the commission on the table, kept on the ladder as in odds.c, the
+// same ticks as the guide and the exchange quote. These are the odds
+// at which our quotes are most likely to be matched, while still
+// having positive expected value.
+//
+// When we hold a position in an outcome, we widen the side of the
+// quote which would add to it, by `skewTicksPerUnit` ticks per unit
+// of position. When we have backed, our back odds go up, and when we
+// have laid, our lay odds go down, but never off the ladder. Widening
+// only makes a quote more profitable, so a widened quote kept at the
+// end of the ladder is still profitable. The other side stays at its
+// tightest profitable odds, so that no quote ever has negative
+// expected value.
+//
+// Moving a quote means cancelling and placing an order on the
+// exchange. We limit this churn in two ways. A quote only moves when
+// its target has moved by at least `minimumTickChange` ticks, and at
+// most `maxUpdatesPerDeal` quotes move on each table between two
+// deals. Quotes which have become unprofitable, or whose outcome is
+// no longer open, always move.
+//
+// The targets are computed for all outcomes of a table in one pass
+// over flat arrays, which the compiler can vectorise. Only the
+// comparison against the live quotes is done outcome by outcome.
+
+struct quoteEngine* createQuoteEngine(int numberTables,
+                                      int numberOutcomes,
+                                      double commission,
+                                      struct quoteParameters* parameters) {
+  struct quoteEngine* engine = malloc(sizeof(struct quoteEngine));
+  int length = numberTables * numberOutcomes;
+
+  engine->numberTables = numberTables;
+  engine->numberOutcomes = numberOutcomes;
+  engine->parameters = *parameters;
+  engine->commissions = calloc(numberTables, sizeof(double));
+  engine->backTicks = calloc(length, sizeof(int));
+  engine->layTicks = calloc(length, sizeof(int));
+  engine->targetBackTicks = calloc(numberOutcomes, sizeof(int));
+  engine->targetLayTicks = calloc(numberOutcomes, sizeof(int));
+  engine->floorBackTicks = calloc(numberOutcomes, sizeof(int));
+  engine->ceilingLayTicks = calloc(numberOutcomes, sizeof(int));
+  engine->changed = calloc(length, sizeof(unsigned char));
+  engine->tokens = calloc(numberTables, sizeof(int));
+
+  for (int table = 0; table < numberTables; table++) {
+    engine->commissions[table] = commission;
+  }
+
+  refillQuoteTokens(engine);
+
+  return engine;
+}
+
+void freeQuoteEngine(struct quoteEngine* engine) {
+  free(engine->commissions);
+  free(engine->backTicks);
+  free(engine->layTicks);
+  free(engine->targetBackTicks);
+  free(engine->targetLayTicks);
+  free(engine->floorBackTicks);
+  free(engine->ceilingLayTicks);
+  free(engine->changed);
+  free(engine->tokens);
+  free(engine);
+}
+
+void setQuoteCommission(struct quoteEngine* engine, int table, double commission) {
+  engine->commissions[table] = commission;
+}
+
+void refillQuoteTokens(struct quoteEngine* engine) {
+  for (int table = 0; table < engine->numberTables; table++) {
+    engine->tokens[table] = engine->parameters.maxUpdatesPerDeal;
+  }
+}
+
+// Compute the target quotes of each outcome of a table, and the
+// limits beyond which the live quotes would be unprofitable.
+static void calculateTargets(struct quoteEngine* engine,
+                             double commission,
+                             double* probabilities,
+                             int* positions) {
+  double skewTicksPerUnit = engine->parameters.skewTicksPerUnit;
+
+  for (int i = 0; i < engine->numberOutcomes; i++) {
+    double probability = probabilities[i];
+    int open = probability > 0 && probability < 1;
+    int backTicks = open ? calculateTightestBackTicks(probability, commission) : NO_ODDS_TICKS;
+    int layTicks = open ? calculateTightestLayTicks(probability, commission) : NO_ODDS_TICKS;
+    long skew = lround(skewTicksPerUnit * positions[i]);
+    long skewedBackTicks = backTicks + skew;
+    long skewedLayTicks = layTicks + skew;
+
+    engine->floorBackTicks[i] = backTicks;
+    engine->ceilingLayTicks[i] = layTicks;
+    engine->targetBackTicks[i] = backTicks == NO_ODDS_TICKS || skew <= 0
+      ? backTicks
+      : (skewedBackTicks < MAX_ODDS_TICKS ? skewedBackTicks : MAX_ODDS_TICKS);
+    engine->targetLayTicks[i] = layTicks == NO_ODDS_TICKS || skew >= 0
+      ? layTicks
+      : (skewedLayTicks > MIN_ODDS_TICKS ? skewedLayTicks : MIN_ODDS_TICKS);
+  }
+}
+
+// Must the live quote be moved, because it is no longer profitable
+// or there should be no quote at all?
+static int isBackQuoteStale(int liveTicks, int targetTicks, int floorTicks) {
+  return liveTicks != NO_ODDS_TICKS && (targetTicks == NO_ODDS_TICKS || liveTicks < floorTicks);
+}
+
+static int isLayQuoteStale(int liveTicks, int targetTicks, int ceilingTicks) {
+  return liveTicks != NO_ODDS_TICKS && (targetTicks == NO_ODDS_TICKS || liveTicks > ceilingTicks);
+}
+
+// Would we like to move the live quote to the target?
+static int isQuoteWorthMoving(int liveTicks, int targetTicks, int minimumTickChange) {
+  if (liveTicks == NO_ODDS_TICKS || targetTicks == NO_ODDS_TICKS) {
+    return liveTicks != targetTicks;
+  }
+
+  return abs(targetTicks - liveTicks) >= minimumTickChange;
+}
+
+// Move a live quote to its target if it has to move, or if it is
+// worth moving and the table has updates left.
+static int moveQuote(int* liveTicks, int targetTicks, int stale, int* tokens, int minimumTickChange) {
+  if (stale) {
+    *liveTicks = targetTicks;
+    return 1;
+  }
+
+  if (*tokens > 0 && isQuoteWorthMoving(*liveTicks, targetTicks, minimumTickChange)) {
+    *liveTicks = targetTicks;
+    (*tokens)--;
+    return 1;
+  }
+
+  return 0;
+}
+
+int requoteTable(struct quoteEngine* engine, int table, double* probabilities, int* positions) {
+  int offset = table * engine->numberOutcomes;
+  int minimumTickChange = engine->parameters.minimumTickChange;
+  int numberChanged = 0;
+
+  calculateTargets(engine, engine->commissions[table], probabilities, positions);
+
+  for (int i = 0; i < engine->numberOutcomes; i++) {
+    int* backTicks = &engine->backTicks[offset + i];
+    int* layTicks = &engine->layTicks[offset + i];
+    int backStale = isBackQuoteStale(*backTicks, engine->targetBackTicks[i], engine->floorBackTicks[i]);
+    int layStale = isLayQuoteStale(*layTicks, engine->targetLayTicks[i], engine->ceilingLayTicks[i]);
+    int changed = 0;
+
+    changed |= moveQuote(backTicks,
+                         engine->targetBackTicks[i],
+                         backStale,
+                         &engine->tokens[table],
+                         minimumTickChange);
+    changed |= moveQuote(layTicks,
+                         engine->targetLayTicks[i],
+                         layStale,
+                         &engine->tokens[table],
+                         minimumTickChange);
+
+    engine->changed[offset + i] = changed;
+    numberChanged += changed;
+  }
+
+  return numberChanged;
+}
+
+int requoteAll(struct quoteEngine* engine, double* probabilities, int* positions) {
+  int numberChanged = 0;
+
+  for (int table = 0; table < engine->numberTables; table++) {
+    int offset = table * engine->numberOutcomes;
+
+    numberChanged += requoteTable(engine, table, probabilities + offset, positions + offset);
+  }
+
+  return numberChanged;
+}
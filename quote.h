@@ -0,0 +1,55 @@
+// A market making engine, quoting odds to back and lay every open
+// outcome on a number of tables. The quotes of outcome `outcome` on
+// table `table` are at index (table * numberOutcomes + outcome) of the
+// quote arrays. A tick value of NO_ODDS_TICKS (see odds.h) means that
+// there is no quote.
+
+struct quoteParameters {
+  // How many ticks to widen quotes by per unit of position.
+  double skewTicksPerUnit;
+  // Only move a quote when it changes by at least this many ticks,
+  // unless the old quote has become unprofitable.
+  int minimumTickChange;
+  // How many quotes may be moved on each table between deals.
+  int maxUpdatesPerDeal;
+};
+
+struct quoteEngine {
+  int numberTables;
+  int numberOutcomes;
+  struct quoteParameters parameters;
+  double* commissions;
+  int* backTicks;
+  int* layTicks;
+  int* targetBackTicks;
+  int* targetLayTicks;
+  int* floorBackTicks;
+  int* ceilingLayTicks;
+  unsigned char* changed;
+  int* tokens;
+};
+
+struct quoteEngine* createQuoteEngine(int numberTables,
+                                      int numberOutcomes,
+                                      double commission,
+                                      struct quoteParameters* parameters);
+
+void freeQuoteEngine(struct quoteEngine* engine);
+
+// Set the commission tier we pay on the given table.
+void setQuoteCommission(struct quoteEngine* engine, int table, double commission);
+
+// Allow another `maxUpdatesPerDeal` quote moves on every table. Call
+// this when a card is dealt.
+void refillQuoteTokens(struct quoteEngine* engine);
+
+// Requote every outcome of every table, given the fair probabilities
+// of the outcomes and our positions in them (in units of stake backed,
+// negative if laid), both laid out like the quote arrays. Outcomes
+// which are settled or not open should have a probability of 0 or 1.
+// Sets `changed` for each quote which moved, and returns how many did.
+int requoteAll(struct quoteEngine* engine, double* probabilities, int* positions);
+
+// Requote the outcomes of one table. `probabilities` and `positions`
+// point to that table's outcomes.
+int requoteTable(struct quoteEngine* engine, int table, double* probabilities, int* positions);
@@ -0,0 +1,125 @@
+#include <stdlib.h>
+#include "state.h"
+#include "range.h"
+
+// Let tails[size][numberLower][k] be the number of ways to deal the
+// next (size - 1) cards from the state (size, numberLower) with at
+// least the first k deals predicted correctly. Every way has a streak
+// of at least 0, so tails[size][numberLower][0] = size!, and no way
+// has a streak of `size` or more. For k >= 1, the first deal must be
+// correct, leading to a state (size - 1, j) from which the streak is
+// at least (k - 1), so
+//
+// tails[size][numberLower][k] = sum over correct j of tails[size - 1][j][k - 1].
+//
+// The correct deals form a single range of j, as in state.c, so the
+// sums are differences of prefix sums over j, taken for each k. The
+// table is filled once from the smallest decks up, after which every
+// range of streaks is two lookups.
+
+static int getNumberTails(int size) {
+  return size + 1;
+}
+
+static int* createSizeOffsets(int maxSize) {
+  int* sizeOffsets = calloc(maxSize + 2, sizeof(int));
+
+  for (int size = 0; size <= maxSize; size++) {
+    sizeOffsets[size + 1] = sizeOffsets[size] + (size + 1) * getNumberTails(size);
+  }
+
+  return sizeOffsets;
+}
+
+static unsigned long int* getTailCounts(struct rangeTable* table, int size, int numberLower) {
+  return table->tailCounts + table->sizeOffsets[size] + numberLower * getNumberTails(size);
+}
+
+static void calculateRangeTable(struct rangeTable* table) {
+  int maxSize = table->maxSize;
+  unsigned long int* prefixSums = calloc(maxSize * (maxSize + 1), sizeof(unsigned long int));
+  unsigned long int numberShuffles = 1;
+
+  for (int numberLower = 0; numberLower <= 1 && numberLower <= maxSize; numberLower++) {
+    getTailCounts(table, 1, numberLower)[0] = 1;
+  }
+
+  for (int size = 2; size <= maxSize; size++) {
+    int smallerSize = size - 1;
+
+    numberShuffles *= size;
+
+    // prefixSums[k * (maxSize + 1) + j] is the sum of the tails at k
+    // over the states below j.
+    for (int k = 0; k < smallerSize; k++) {
+      unsigned long int* sums = &prefixSums[k * (maxSize + 1)];
+
+      for (int j = 0; j <= smallerSize; j++) {
+        sums[j + 1] = sums[j] + getTailCounts(table, smallerSize, j)[k];
+      }
+    }
+
+    for (int numberLower = 0; numberLower <= size; numberLower++) {
+      unsigned long int* tails = getTailCounts(table, size, numberLower);
+      int higher = predictsHigher(size, numberLower);
+      int start = higher ? numberLower : 0;
+      int end = higher ? size : numberLower;
+
+      tails[0] = numberShuffles;
+
+      for (int k = 1; k < size; k++) {
+        unsigned long int* sums = &prefixSums[(k - 1) * (maxSize + 1)];
+
+        tails[k] = sums[end] - sums[start];
+      }
+    }
+  }
+
+  free(prefixSums);
+}
+
+struct rangeTable* createRangeTable(int maxSize) {
+  struct rangeTable* table = malloc(sizeof(struct rangeTable));
+
+  table->maxSize = maxSize;
+  table->sizeOffsets = createSizeOffsets(maxSize);
+  table->tailCounts = calloc(table->sizeOffsets[maxSize + 1], sizeof(unsigned long int));
+
+  calculateRangeTable(table);
+
+  return table;
+}
+
+void freeRangeTable(struct rangeTable* table) {
+  free(table->sizeOffsets);
+  free(table->tailCounts);
+  free(table);
+}
+
+// Streaks outside [0, size] are clamped to it, so that open ended
+// ranges can be asked for.
+static int clampStreak(int streak, int size) {
+  return streak < 0 ? 0 : (streak > size ? size : streak);
+}
+
+unsigned long int getStreakRangeCount(struct rangeTable* table,
+                                      int size,
+                                      int numberLower,
+                                      int first,
+                                      int last) {
+  unsigned long int* tails = getTailCounts(table, size, numberLower);
+
+  first = clampStreak(first, size);
+  last = clampStreak(last, size);
+
+  return first < last ? tails[first] - tails[last] : 0;
+}
+
+double getStreakRangeProbability(struct rangeTable* table,
+                                 int size,
+                                 int numberLower,
+                                 int first,
+                                 int last) {
+  return (double) getStreakRangeCount(table, size, numberLower, first, last)
+    / getTailCounts(table, size, numberLower)[0];
+}
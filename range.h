@@ -0,0 +1,38 @@
+// Events on the length of the computer's streak of correct
+// predictions from a state, for every state with a `size` of at most
+// `maxSize`. The streak is the number of deals predicted correctly
+// before the first wrong prediction, from 0 up to
+// getLengthOfProbabilities(size). The outcome at index n in prob.c is
+// a streak of at least (n + 1).
+//
+// Each state keeps the exact number of ways to deal the rest of the
+// deck with a streak of at least k, for every k, out of `size`! ways.
+// The number of ways for the streak to fall in any range is then the
+// difference of two of them. These fit in 64 bits for decks of up to
+// 20 cards.
+#define MAX_RANGE_SIZE 20
+
+struct rangeTable {
+  int maxSize;
+  int* sizeOffsets;
+  unsigned long int* tailCounts;
+};
+
+struct rangeTable* createRangeTable(int maxSize);
+
+void freeRangeTable(struct rangeTable* table);
+
+// The number of ways, out of `size`!, for the streak from the state
+// (size, numberLower) to be at least `first` and less than `last`. A
+// streak of exactly n is the range [n, n + 1).
+unsigned long int getStreakRangeCount(struct rangeTable* table,
+                                      int size,
+                                      int numberLower,
+                                      int first,
+                                      int last);
+
+double getStreakRangeProbability(struct rangeTable* table,
+                                 int size,
+                                 int numberLower,
+                                 int first,
+                                 int last);
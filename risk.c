@@ -0,0 +1,276 @@
+#include <stdlib.h>
+#include "odds.h"
+#include "state.h"
+#include "risk.h"
+
+// Each bet adds one amount to the profit of every streak shorter than
+// (outcome + 1), and another to every streak at least that long. We
+// map many bets onto the profit per streak length of their games by
+// adding the first amount to the start of a difference array, and the
+// change between the two at (outcome + 1). One prefix sum per game
+// then turns the differences into profits, so mapping bets takes time
+// linear in the number of bets plus the number of outcomes.
+//
+// The games are independent, so the worst case over all games is the
+// sum of the worst cases of each game, and likewise for the expected
+// profit. We keep both for each game and their totals over all games,
+// so that a bet can be checked against a limit by looking only at
+// the profits of its own game.
+//
+// The worst case is taken over the streak lengths which can happen.
+// Their probabilities are differences of floating point outcome
+// probabilities, which cannot tell a length which is impossible from
+// one which is merely very unlikely for every size of deck, so which
+// lengths can happen is worked out separately, exactly.
+
+// Whether the streak from each state can end at each length, packed by
+// state as in state.h and then by length. From a state with fewer than
+// two cards, the streak can only be 0. Otherwise, it can be 0 if some
+// deal is predicted wrongly, and (k + 1) if some deal is predicted
+// correctly and leads to a state from which the streak can be k.
+static unsigned char* createPossibleStreaks(int maxSize) {
+  unsigned char* possibleStreaks = calloc(getNumberStates(maxSize) * maxSize, sizeof(unsigned char));
+
+  for (int size = 0; size <= maxSize; size++) {
+    for (int numberLower = 0; numberLower <= size; numberLower++) {
+      unsigned char* possible = &possibleStreaks[getStateIndex(size, numberLower) * maxSize];
+
+      if (size < 2) {
+        possible[0] = 1;
+        continue;
+      }
+
+      for (int position = 0; position < size; position++) {
+        if (!isCorrectPrediction(size, numberLower, position)) {
+          possible[0] = 1;
+          continue;
+        }
+
+        unsigned char* next = &possibleStreaks[getStateIndex(size - 1, position) * maxSize];
+
+        for (int k = 0; k < size - 1; k++) {
+          possible[k + 1] |= next[k];
+        }
+      }
+    }
+  }
+
+  return possibleStreaks;
+}
+
+struct riskEngine* createRiskEngine(int numberGames, int maxSize, double commission) {
+  struct riskEngine* engine = malloc(sizeof(struct riskEngine));
+
+  engine->numberGames = numberGames;
+  engine->maxSize = maxSize;
+  engine->commission = commission;
+  engine->games = calloc(numberGames, sizeof(struct riskGame));
+  engine->profits = calloc(numberGames * maxSize, sizeof(double));
+  engine->streakProbabilities = calloc(numberGames * maxSize, sizeof(double));
+  engine->differences = calloc(numberGames * (maxSize + 1), sizeof(double));
+  engine->touchedGames = calloc(numberGames, sizeof(int));
+  engine->isTouched = calloc(numberGames, sizeof(unsigned char));
+  engine->table = createOutcomeTable(maxSize);
+  engine->possibleStreaks = createPossibleStreaks(maxSize);
+  engine->totalWorstCase = 0;
+  engine->totalExpected = 0;
+
+  return engine;
+}
+
+void freeRiskEngine(struct riskEngine* engine) {
+  free(engine->games);
+  free(engine->profits);
+  free(engine->streakProbabilities);
+  free(engine->differences);
+  free(engine->touchedGames);
+  free(engine->isTouched);
+  freeOutcomeTable(engine->table);
+  free(engine->possibleStreaks);
+  free(engine);
+}
+
+double getRiskProfit(struct riskEngine* engine, int game, int streak) {
+  return engine->profits[game * engine->maxSize + streak];
+}
+
+// The probability of each final streak length. Once a prediction has
+// failed, the streak is known. Otherwise it is the current streak
+// plus the streak from the current state, which is at least k with
+// the probability of the current state's outcome at index (k - 1).
+static void calculateStreakProbabilities(struct riskEngine* engine, int game) {
+  struct riskGame* riskGame = &engine->games[game];
+  double* streakProbabilities = &engine->streakProbabilities[game * engine->maxSize];
+
+  for (int i = 0; i < engine->maxSize; i++) {
+    streakProbabilities[i] = 0;
+  }
+
+  if (riskGame->settled || riskGame->size < 2) {
+    streakProbabilities[riskGame->streak] = 1;
+    return;
+  }
+
+  double* outcomes = getOutcomeProbabilities(engine->table, riskGame->size, riskGame->numberLower);
+  double atLeast = 1;
+
+  for (int k = 0; k < riskGame->size; k++) {
+    double atLeastOneMore = k < riskGame->size - 1 ? outcomes[k] : 0;
+
+    streakProbabilities[riskGame->streak + k] = atLeast - atLeastOneMore;
+    atLeast = atLeastOneMore;
+  }
+}
+
+// Can the final streak of a game be `streak` long?
+static int isPossibleStreak(struct riskEngine* engine, struct riskGame* riskGame, int streak) {
+  if (riskGame->settled || riskGame->size < 2) {
+    return streak == riskGame->streak;
+  }
+
+  int k = streak - riskGame->streak;
+  int index = getStateIndex(riskGame->size, riskGame->numberLower);
+
+  return k >= 0 && k < riskGame->size && engine->possibleStreaks[index * engine->maxSize + k];
+}
+
+// Recompute the worst case and expected profit of a game, and the
+// totals over all games.
+static void summariseGame(struct riskEngine* engine, int game) {
+  struct riskGame* riskGame = &engine->games[game];
+  double* profits = &engine->profits[game * engine->maxSize];
+  double* streakProbabilities = &engine->streakProbabilities[game * engine->maxSize];
+  double worstCase = 0;
+  double expected = 0;
+  int first = 1;
+
+  for (int i = 0; i < riskGame->startSize; i++) {
+    if (isPossibleStreak(engine, riskGame, i)) {
+      if (first || profits[i] < worstCase) {
+        worstCase = profits[i];
+        first = 0;
+      }
+
+      expected += streakProbabilities[i] * profits[i];
+    }
+  }
+
+  engine->totalWorstCase += worstCase - riskGame->worstCase;
+  engine->totalExpected += expected - riskGame->expected;
+  riskGame->worstCase = worstCase;
+  riskGame->expected = expected;
+}
+
+void startRiskGame(struct riskEngine* engine, int game, int size, int numberLower) {
+  struct riskGame* riskGame = &engine->games[game];
+  double* profits = &engine->profits[game * engine->maxSize];
+
+  riskGame->startSize = size;
+  riskGame->size = size;
+  riskGame->numberLower = numberLower;
+  riskGame->streak = 0;
+  riskGame->settled = 0;
+
+  for (int i = 0; i < engine->maxSize; i++) {
+    profits[i] = 0;
+  }
+
+  calculateStreakProbabilities(engine, game);
+  summariseGame(engine, game);
+}
+
+void dealRiskGame(struct riskEngine* engine, int game, int size, int numberLower, int correct) {
+  struct riskGame* riskGame = &engine->games[game];
+
+  if (!riskGame->settled) {
+    if (correct) {
+      riskGame->streak++;
+    } else {
+      riskGame->settled = 1;
+    }
+  }
+
+  riskGame->size = size;
+  riskGame->numberLower = numberLower;
+
+  calculateStreakProbabilities(engine, game);
+  summariseGame(engine, game);
+}
+
+// The profit of a bet if its outcome is lost, and if it is won.
+static void getBetProfits(struct riskEngine* engine, struct bet* bet, double* lost, double* won) {
+  double k = 1 - engine->commission;
+  double odds = (double) bet->oddsTicks / TICKS_IN_UNIT;
+
+  if (bet->lay) {
+    *lost = bet->stake * k;
+    *won = -bet->stake * (odds - 1);
+  } else {
+    *lost = -bet->stake;
+    *won = bet->stake * (odds - 1) * k;
+  }
+}
+
+void addRiskBets(struct riskEngine* engine, struct bet* bets, int numberBets) {
+  int numberTouched = 0;
+
+  for (int i = 0; i < numberBets; i++) {
+    int game = bets[i].game;
+    double* differences = &engine->differences[game * (engine->maxSize + 1)];
+    double lost;
+    double won;
+
+    getBetProfits(engine, &bets[i], &lost, &won);
+
+    differences[0] += lost;
+    differences[bets[i].outcome + 1] += won - lost;
+
+    if (!engine->isTouched[game]) {
+      engine->isTouched[game] = 1;
+      engine->touchedGames[numberTouched++] = game;
+    }
+  }
+
+  for (int i = 0; i < numberTouched; i++) {
+    int game = engine->touchedGames[i];
+    double* differences = &engine->differences[game * (engine->maxSize + 1)];
+    double* profits = &engine->profits[game * engine->maxSize];
+    double sum = 0;
+
+    for (int streak = 0; streak < engine->maxSize; streak++) {
+      sum += differences[streak];
+      profits[streak] += sum;
+    }
+
+    for (int streak = 0; streak <= engine->maxSize; streak++) {
+      differences[streak] = 0;
+    }
+
+    engine->isTouched[game] = 0;
+    summariseGame(engine, game);
+  }
+}
+
+int wouldExceedRiskLimit(struct riskEngine* engine, struct bet* bet, double maxLoss) {
+  struct riskGame* riskGame = &engine->games[bet->game];
+  double* profits = &engine->profits[bet->game * engine->maxSize];
+  double worstCase = 0;
+  int first = 1;
+  double lost;
+  double won;
+
+  getBetProfits(engine, bet, &lost, &won);
+
+  for (int i = 0; i < riskGame->startSize; i++) {
+    if (isPossibleStreak(engine, riskGame, i)) {
+      double profit = profits[i] + (i > bet->outcome ? won : lost);
+
+      if (first || profit < worstCase) {
+        worstCase = profit;
+        first = 0;
+      }
+    }
+  }
+
+  return engine->totalWorstCase - riskGame->worstCase + worstCase < -maxLoss;
+}
@@ -0,0 +1,70 @@
+// Track the profit and loss of our matched bets over many concurrent
+// games. The outcomes of a game (see prob.c) are nested: the outcome
+// at index n of the state the game started in is won exactly when
+// the computer's streak of correct predictions from that state
+// reaches (n + 1). The profit of any book of bets on a game is
+// therefore a function of the final length of the streak alone.
+
+struct bet {
+  int game;
+  // The index of the outcome in the state the game started in.
+  int outcome;
+  // Whether we laid rather than backed.
+  int lay;
+  int oddsTicks;
+  double stake;
+};
+
+struct riskGame {
+  int startSize;
+  int size;
+  int numberLower;
+  // How many predictions have been correct so far.
+  int streak;
+  // Whether a prediction has failed, ending the streak.
+  int settled;
+  double worstCase;
+  double expected;
+};
+
+struct riskEngine {
+  int numberGames;
+  int maxSize;
+  double commission;
+  struct riskGame* games;
+  // For each game, the profit for each final streak length from 0 to
+  // (maxSize - 1), and the probability of that length.
+  double* profits;
+  double* streakProbabilities;
+  double* differences;
+  int* touchedGames;
+  unsigned char* isTouched;
+  struct outcomeTable* table;
+  // Whether the streak from each state can end at each length.
+  unsigned char* possibleStreaks;
+  double totalWorstCase;
+  double totalExpected;
+};
+
+struct riskEngine* createRiskEngine(int numberGames, int maxSize, double commission);
+
+void freeRiskEngine(struct riskEngine* engine);
+
+// Start tracking a new game on `game`, with no bets, in the state
+// (size, numberLower).
+void startRiskGame(struct riskEngine* engine, int game, int size, int numberLower);
+
+// Record that a card was dealt in `game`, leading to the state (size,
+// numberLower), and whether the computer predicted it correctly.
+void dealRiskGame(struct riskEngine* engine, int game, int size, int numberLower, int correct);
+
+// Add matched bets to the books of their games.
+void addRiskBets(struct riskEngine* engine, struct bet* bets, int numberBets);
+
+// Would the worst case loss over all games exceed `maxLoss` if `bet`
+// were matched? This leaves the books unchanged.
+int wouldExceedRiskLimit(struct riskEngine* engine, struct bet* bet, double maxLoss);
+
+// The profit of the book on `game` if its final streak has length
+// `streak`.
+double getRiskProfit(struct riskEngine* engine, int game, int streak);
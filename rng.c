@@ -0,0 +1,24 @@
+#include "rng.h"
+
+void seedRandom(struct randomState* random, uint64_t seed) {
+  random->state = seed;
+}
+
+uint64_t nextRandom(struct randomState* random) {
+  uint64_t z = (random->state += 0x9e3779b97f4a7c15);
+
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+
+  return z ^ (z >> 31);
+}
+
+// Map the top 32 bits onto the range by multiplication, which has a
+// negligible bias for the small bounds used here.
+int nextRandomBelow(struct randomState* random, int bound) {
+  return (int) (((nextRandom(random) >> 32) * (uint64_t) bound) >> 32);
+}
+
+double nextRandomDouble(struct randomState* random) {
+  return (nextRandom(random) >> 11) * (1.0 / 9007199254740992.0);
+}
@@ -0,0 +1,18 @@
+#include <stdint.h>
+
+// A small, fast pseudo random number generator (splitmix64). Streams
+// seeded with different seeds are independent for simulation
+// purposes, and the same seed always reproduces the same stream.
+struct randomState {
+  uint64_t state;
+};
+
+void seedRandom(struct randomState* random, uint64_t seed);
+
+uint64_t nextRandom(struct randomState* random);
+
+// A uniformly distributed integer with 0 <= value < bound.
+int nextRandomBelow(struct randomState* random, int bound);
+
+// A uniformly distributed double with 0 <= value < 1.
+double nextRandomDouble(struct randomState* random);
@@ -0,0 +1,320 @@
+#include <stdlib.h>
+#include <string.h>
+#include "pool.h"
+#include "state.h"
+#include "history.h"
+#include "scan.h"
+
+// A scan tests a group of LANES rows at a time, with the GCC vector
+// extensions, which compile to the vector instructions of the target,
+// or to plain loops where there are none. Each column of a group is
+// loaded into one vector of 32 bit lanes, widened from narrower
+// columns, and every test gives a mask with all bits set in the lanes
+// of the rows which pass it. The masks are combined and summed without
+// a branch per row. Counts are summed per lane over a block, and only
+// added up across the lanes once per block. The odds of a row are at
+// most MAX_ODDS_TICKS (see appendHistoryRow), so their sums fit 32 bit
+// lanes over a block, as do the counts. The matched stakes are not
+// bounded, and are summed in two halves of 16 bits. Every column of a
+// block has a whole number of groups, and the rows past the end of a
+// block have a size of 0, which no filter lets through, so there is
+// no partial group to handle.
+//
+// Before scanning a block, its range of times and set of sizes are
+// checked against the filter, which skips most blocks for queries on
+// a period or a deck size. The blocks are split between the workers in
+// contiguous runs, each worker aggregating into its own results, which
+// are added up at the end.
+
+// Four 32 bit lanes fill the 128 bit vector registers which every
+// 64 bit x86 and ARM processor has. Wider vectors are split across
+// several registers without AVX, and the accumulators of a scan then
+// no longer fit in the registers.
+#define LANES 4
+
+// The number of tasks per worker to aim for, so that workers which
+// skip many blocks can steal the blocks of the others.
+#define TASKS_PER_WORKER 4
+
+typedef uint8_t byteLanes __attribute__((vector_size(LANES)));
+typedef uint32_t wordLanes __attribute__((vector_size(LANES * sizeof(uint32_t))));
+typedef int32_t maskLanes __attribute__((vector_size(LANES * sizeof(int32_t))));
+
+// A filter, in the terms of one block.
+struct blockBounds {
+  uint32_t firstTime;
+  uint32_t lastTime;
+  uint32_t minSize;
+  uint32_t maxSize;
+  uint32_t minNumberLower;
+  uint32_t maxNumberLower;
+  uint32_t winningCard;
+};
+
+struct scanTask {
+  struct historyStore* store;
+  struct historyFilter* filter;
+  int firstBlock;
+  int endBlock;
+  int grouped;
+  // The results of each worker.
+  struct historyAggregate** results;
+};
+
+void initialiseHistoryFilter(struct historyFilter* filter) {
+  filter->firstTime = INT64_MIN;
+  filter->lastTime = INT64_MAX;
+  filter->minSize = 0;
+  filter->maxSize = UINT8_MAX;
+  filter->minNumberLower = 0;
+  filter->maxNumberLower = UINT8_MAX;
+  filter->winningCard = 0;
+}
+
+static int clamp(int value, int low, int high) {
+  return value < low ? low : value > high ? high : value;
+}
+
+// Translate the filter into the terms of `block`. Return 0 if no row
+// of the block can match.
+static int getBlockBounds(struct historyFilter* filter, struct historyBlock* block, struct blockBounds* bounds) {
+  int minSize = clamp(filter->minSize, 1, UINT8_MAX);
+  int maxSize = clamp(filter->maxSize, 0, UINT8_MAX);
+  int minNumberLower = clamp(filter->minNumberLower, 0, UINT8_MAX);
+  int maxNumberLower = clamp(filter->maxNumberLower, 0, UINT8_MAX);
+
+  if (block->numberRows == 0
+      || filter->lastTime < block->firstTime
+      || filter->firstTime > block->lastTime
+      || minSize > maxSize
+      || filter->maxNumberLower < 0
+      || filter->minNumberLower > UINT8_MAX
+      || minNumberLower > maxNumberLower) {
+    return 0;
+  }
+
+  uint64_t sizeMask = (~0ULL << (minSize < 63 ? minSize : 63)) & (~0ULL >> (63 - (maxSize < 63 ? maxSize : 63)));
+
+  if ((block->sizeMask & sizeMask) == 0) {
+    return 0;
+  }
+
+  bounds->firstTime = filter->firstTime <= block->firstTime ? 0 : filter->firstTime - block->firstTime;
+  bounds->lastTime = (filter->lastTime >= block->lastTime ? block->lastTime : filter->lastTime) - block->firstTime;
+  bounds->minSize = minSize;
+  bounds->maxSize = maxSize;
+  bounds->minNumberLower = minNumberLower;
+  bounds->maxNumberLower = maxNumberLower;
+  bounds->winningCard = clamp(filter->winningCard, 0, UINT8_MAX + 1);
+
+  return 1;
+}
+
+// The vectors are passed through pointers rather than by value, as
+// the ABI for passing them by value depends on the target's vector
+// instructions. The functions are inlined either way.
+static inline void loadBytes(wordLanes* words, const uint8_t* column) {
+  byteLanes bytes;
+
+  memcpy(&bytes, column, sizeof(bytes));
+  *words = __builtin_convertvector(bytes, wordLanes);
+}
+
+static inline void loadWords(wordLanes* words, const uint32_t* column) {
+  memcpy(words, column, sizeof(*words));
+}
+
+// The rows of the group starting at `row` which pass the filter.
+static inline void matchRows(maskLanes* match, struct historyBlock* block, struct blockBounds* bounds, int row) {
+  wordLanes times;
+  wordLanes sizes;
+  wordLanes numbersLower;
+
+  loadWords(&times, &block->times[row]);
+  loadBytes(&sizes, &block->sizes[row]);
+  loadBytes(&numbersLower, &block->numbersLower[row]);
+
+  *match = (times >= bounds->firstTime) & (times <= bounds->lastTime)
+    & (sizes >= bounds->minSize) & (sizes <= bounds->maxSize)
+    & (numbersLower >= bounds->minNumberLower) & (numbersLower <= bounds->maxNumberLower);
+}
+
+static void scanBlock(struct historyBlock* block, struct blockBounds* bounds, struct historyAggregate* result) {
+  maskLanes numberRows = {0};
+  maskLanes numberWon = {0};
+  maskLanes numberQuoted = {0};
+  wordLanes backTicks = {0};
+  wordLanes layTicks = {0};
+  wordLanes lowMatchedStake = {0};
+  wordLanes highMatchedStake = {0};
+
+  for (int row = 0; row < block->numberRows; row += LANES) {
+    maskLanes match;
+    wordLanes back;
+    wordLanes lay;
+    wordLanes lastCorrectCards;
+    wordLanes matchedStakes;
+
+    matchRows(&match, block, bounds, row);
+    loadWords(&back, &block->backTicks[row]);
+    loadWords(&lay, &block->layTicks[row]);
+    loadBytes(&lastCorrectCards, &block->lastCorrectCards[row]);
+    loadWords(&matchedStakes, &block->matchedStakes[row]);
+
+    maskLanes won = match & (lastCorrectCards >= bounds->winningCard);
+    maskLanes quoted = match & (back != 0) & (lay != 0);
+
+    numberRows -= match;
+    numberWon -= won;
+    numberQuoted -= quoted;
+    backTicks += back & (wordLanes) quoted;
+    layTicks += lay & (wordLanes) quoted;
+    matchedStakes &= (wordLanes) match;
+    lowMatchedStake += matchedStakes & 0xffff;
+    highMatchedStake += matchedStakes >> 16;
+  }
+
+  for (int lane = 0; lane < LANES; lane++) {
+    result->numberRows += numberRows[lane];
+    result->numberWon += numberWon[lane];
+    result->numberQuoted += numberQuoted[lane];
+    result->backTicks += backTicks[lane];
+    result->layTicks += layTicks[lane];
+    result->matchedStake += lowMatchedStake[lane] + ((long) highMatchedStake[lane] << 16);
+  }
+}
+
+// The rows are tested a group at a time as in `scanBlock`, and then
+// added to the aggregate of their state one at a time. Rows which do
+// not match are added to the aggregate at `discarded` instead, so that
+// no row needs a branch.
+static void groupBlock(struct historyBlock* block,
+                       struct blockBounds* bounds,
+                       struct historyAggregate* groups,
+                       uint32_t discarded) {
+  for (int row = 0; row < block->numberRows; row += LANES) {
+    maskLanes match;
+    wordLanes sizes;
+    wordLanes numbersLower;
+    wordLanes back;
+    wordLanes lay;
+    wordLanes lastCorrectCards;
+    wordLanes matchedStakes;
+
+    matchRows(&match, block, bounds, row);
+    loadBytes(&sizes, &block->sizes[row]);
+    loadBytes(&numbersLower, &block->numbersLower[row]);
+    loadWords(&back, &block->backTicks[row]);
+    loadWords(&lay, &block->layTicks[row]);
+    loadBytes(&lastCorrectCards, &block->lastCorrectCards[row]);
+    loadWords(&matchedStakes, &block->matchedStakes[row]);
+
+    maskLanes won = match & (lastCorrectCards >= bounds->winningCard);
+    maskLanes quoted = match & (back != 0) & (lay != 0);
+    // As in getStateIndex in state.c.
+    wordLanes states = sizes * (sizes + 1) / 2 + numbersLower;
+
+    states = (states & (wordLanes) match) | (discarded & (wordLanes) ~match);
+
+    for (int lane = 0; lane < LANES; lane++) {
+      struct historyAggregate* group = &groups[states[lane]];
+
+      group->numberRows++;
+      group->numberWon -= won[lane];
+      group->numberQuoted -= quoted[lane];
+      group->backTicks += back[lane] & quoted[lane];
+      group->layTicks += lay[lane] & quoted[lane];
+      group->matchedStake += matchedStakes[lane] & match[lane];
+    }
+  }
+}
+
+static void runScanTask(void* argument, int worker) {
+  struct scanTask* task = argument;
+  struct historyAggregate* results = task->results[worker];
+  uint32_t discarded = getNumberStates(task->store->maxSize);
+
+  for (int i = task->firstBlock; i < task->endBlock; i++) {
+    struct historyBlock* block = &task->store->blocks[i];
+    struct blockBounds bounds;
+
+    if (!getBlockBounds(task->filter, block, &bounds)) {
+      continue;
+    }
+
+    if (task->grouped) {
+      groupBlock(block, &bounds, results, discarded);
+    } else {
+      scanBlock(block, &bounds, results);
+    }
+  }
+}
+
+static void runScan(struct workPool* pool,
+                    struct historyStore* store,
+                    struct historyFilter* filter,
+                    int grouped,
+                    struct historyAggregate* output) {
+  int numberWorkers = getNumberWorkers(pool);
+  // Grouping has an extra aggregate for the rows which do not match.
+  int numberResults = grouped ? getNumberStates(store->maxSize) + 1 : 1;
+  int numberTasks = numberWorkers * TASKS_PER_WORKER;
+  struct historyAggregate** results = calloc(numberWorkers, sizeof(struct historyAggregate*));
+
+  if (numberTasks > store->numberBlocks) {
+    numberTasks = store->numberBlocks;
+  }
+
+  struct scanTask* tasks = calloc(numberTasks, sizeof(struct scanTask));
+
+  for (int worker = 0; worker < numberWorkers; worker++) {
+    results[worker] = calloc(numberResults, sizeof(struct historyAggregate));
+  }
+
+  for (int i = 0; i < numberTasks; i++) {
+    tasks[i].store = store;
+    tasks[i].filter = filter;
+    tasks[i].firstBlock = (long) store->numberBlocks * i / numberTasks;
+    tasks[i].endBlock = (long) store->numberBlocks * (i + 1) / numberTasks;
+    tasks[i].grouped = grouped;
+    tasks[i].results = results;
+    submitWork(pool, i, runScanTask, &tasks[i]);
+  }
+
+  waitForWork(pool);
+
+  // The discarded rows are left out of the output.
+  int numberOutputs = grouped ? numberResults - 1 : 1;
+
+  memset(output, 0, numberOutputs * sizeof(struct historyAggregate));
+
+  for (int worker = 0; worker < numberWorkers; worker++) {
+    for (int i = 0; i < numberOutputs; i++) {
+      output[i].numberRows += results[worker][i].numberRows;
+      output[i].numberWon += results[worker][i].numberWon;
+      output[i].numberQuoted += results[worker][i].numberQuoted;
+      output[i].backTicks += results[worker][i].backTicks;
+      output[i].layTicks += results[worker][i].layTicks;
+      output[i].matchedStake += results[worker][i].matchedStake;
+    }
+
+    free(results[worker]);
+  }
+
+  free(results);
+  free(tasks);
+}
+
+void scanHistory(struct workPool* pool,
+                 struct historyStore* store,
+                 struct historyFilter* filter,
+                 struct historyAggregate* result) {
+  runScan(pool, store, filter, 0, result);
+}
+
+void groupHistoryByState(struct workPool* pool,
+                         struct historyStore* store,
+                         struct historyFilter* filter,
+                         struct historyAggregate* groups) {
+  runScan(pool, store, filter, 1, groups);
+}
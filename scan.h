@@ -0,0 +1,52 @@
+#include <stdint.h>
+
+// Queries over a store of recorded stages (see history.h), answered by
+// scanning its columns on a work pool (see pool.h).
+
+// The rows to aggregate: those dealt between `firstTime` and
+// `lastTime` inclusive, in states with a size between `minSize` and
+// `maxSize` and a number lower between `minNumberLower` and
+// `maxNumberLower`, inclusive. A row counts as won when the computer
+// predicted correctly at least up to and including Card
+// `winningCard`, as for the outcome "Card n or further" (see prob.c).
+struct historyFilter {
+  int64_t firstTime;
+  int64_t lastTime;
+  int minSize;
+  int maxSize;
+  int minNumberLower;
+  int maxNumberLower;
+  int winningCard;
+};
+
+// The number of matching rows, how many of them were won, and, over
+// the rows quoted on both sides, the sums of the odds in ticks. The
+// matched stake is summed over every matching row.
+struct historyAggregate {
+  long numberRows;
+  long numberWon;
+  long numberQuoted;
+  long backTicks;
+  long layTicks;
+  long matchedStake;
+};
+
+struct workPool;
+struct historyStore;
+
+// A filter which matches every row.
+void initialiseHistoryFilter(struct historyFilter* filter);
+
+void scanHistory(struct workPool* pool,
+                 struct historyStore* store,
+                 struct historyFilter* filter,
+                 struct historyAggregate* result);
+
+// Aggregate the matching rows of each state separately, into
+// `groups`, which has an aggregate for each of the
+// getNumberStates(store->maxSize) states, indexed by getStateIndex
+// (see state.h).
+void groupHistoryByState(struct workPool* pool,
+                         struct historyStore* store,
+                         struct historyFilter* filter,
+                         struct historyAggregate* groups);
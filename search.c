@@ -0,0 +1,230 @@
+#include <stdlib.h>
+#include <math.h>
+#include "state.h"
+#include "pool.h"
+#include "search.h"
+
+// Each round simulates the next `gamesPerRound` games for every
+// candidate which has not been eliminated. The round is split into
+// tasks of `gamesPerTask` games of one candidate each, which are
+// spread over the workers of a work stealing pool, so that workers
+// which finish early take over the tasks of the others.
+//
+// All candidates play the same games (see simulate.h), so we compare
+// them by the differences of their profits game by game. The mean of
+// these differences is the difference of the candidates' means over
+// all games so far. Its standard error is estimated from the variance
+// of the differences over the games of the last round.
+
+struct searchTask {
+  struct market* market;
+  struct candidate* candidate;
+  struct outcomeTable* table;
+  long firstGame;
+  int numberGames;
+  double* profits;
+};
+
+struct candidate* createCandidateGrid(double commission,
+                                      double stakeFraction,
+                                      int* edgeThresholdTicks,
+                                      int numberThresholds,
+                                      unsigned long* outcomeMasks,
+                                      int numberMasks,
+                                      int* numberCandidates) {
+  struct candidate* candidates = calloc(numberThresholds * numberMasks, sizeof(struct candidate));
+  int number = 0;
+
+  for (int i = 0; i < numberThresholds; i++) {
+    for (int j = 0; j < numberMasks; j++) {
+      struct strategy* strategy = &candidates[number++].strategy;
+
+      strategy->commission = commission;
+      strategy->edgeThresholdTicks = edgeThresholdTicks[i];
+      strategy->stakeFraction = stakeFraction;
+      strategy->outcomeMask = outcomeMasks[j];
+    }
+  }
+
+  *numberCandidates = number;
+
+  return candidates;
+}
+
+void freeCandidates(struct candidate* candidates) {
+  free(candidates);
+}
+
+static void runSearchTask(void* argument, int worker) {
+  struct searchTask* task = argument;
+
+  (void) worker;
+
+  // searchStrategies has checked the size of the market.
+  simulateGames(task->market,
+                &task->candidate->strategy,
+                task->table,
+                task->firstGame,
+                task->numberGames,
+                task->profits);
+}
+
+// Simulate one round for every remaining candidate. The profits of
+// candidate i on game g of the round are left in
+// profits[i * gamesPerRound + g].
+static void simulateRound(struct workPool* pool,
+                          struct market* market,
+                          struct outcomeTable* table,
+                          struct candidate* candidates,
+                          int numberCandidates,
+                          struct searchParameters* parameters,
+                          struct searchTask* tasks,
+                          long firstGame,
+                          double* profits) {
+  int gamesPerRound = parameters->gamesPerRound;
+  int numberTasks = 0;
+
+  for (int i = 0; i < numberCandidates; i++) {
+    if (candidates[i].eliminated) {
+      continue;
+    }
+
+    for (int game = 0; game < gamesPerRound; game += parameters->gamesPerTask) {
+      struct searchTask* task = &tasks[numberTasks];
+      int remaining = gamesPerRound - game;
+
+      task->market = market;
+      task->candidate = &candidates[i];
+      task->table = table;
+      task->firstGame = firstGame + game;
+      task->numberGames = remaining < parameters->gamesPerTask ? remaining : parameters->gamesPerTask;
+      task->profits = &profits[(long) i * gamesPerRound + game];
+
+      submitWork(pool, numberTasks++, runSearchTask, task);
+    }
+  }
+
+  waitForWork(pool);
+}
+
+static int findBestCandidate(struct candidate* candidates, int numberCandidates) {
+  int best = -1;
+
+  for (int i = 0; i < numberCandidates; i++) {
+    if (!candidates[i].eliminated && (best < 0 || candidates[i].mean > candidates[best].mean)) {
+      best = i;
+    }
+  }
+
+  return best;
+}
+
+// Update the means of the remaining candidates, and eliminate those
+// which are clearly worse than the best.
+static int eliminateCandidates(struct candidate* candidates,
+                               int numberCandidates,
+                               struct searchParameters* parameters,
+                               double* profits) {
+  int gamesPerRound = parameters->gamesPerRound;
+
+  for (int i = 0; i < numberCandidates; i++) {
+    if (candidates[i].eliminated) {
+      continue;
+    }
+
+    for (int game = 0; game < gamesPerRound; game++) {
+      candidates[i].sum += profits[(long) i * gamesPerRound + game];
+    }
+
+    candidates[i].numberGames += gamesPerRound;
+    candidates[i].mean = candidates[i].sum / candidates[i].numberGames;
+  }
+
+  int best = findBestCandidate(candidates, numberCandidates);
+  double* bestProfits = &profits[(long) best * gamesPerRound];
+
+  for (int i = 0; i < numberCandidates; i++) {
+    if (candidates[i].eliminated || i == best) {
+      continue;
+    }
+
+    double* candidateProfits = &profits[(long) i * gamesPerRound];
+    double roundMean = 0;
+    double sumSquares = 0;
+
+    for (int game = 0; game < gamesPerRound; game++) {
+      roundMean += candidateProfits[game] - bestProfits[game];
+    }
+
+    roundMean /= gamesPerRound;
+
+    for (int game = 0; game < gamesPerRound; game++) {
+      double deviation = candidateProfits[game] - bestProfits[game] - roundMean;
+
+      sumSquares += deviation * deviation;
+    }
+
+    double variance = gamesPerRound > 1 ? sumSquares / (gamesPerRound - 1) : 0;
+    double standardError = sqrt(variance / candidates[i].numberGames);
+    double difference = candidates[i].mean - candidates[best].mean;
+
+    candidates[i].standardError = standardError;
+
+    if (difference < -parameters->eliminationStandardErrors * standardError) {
+      candidates[i].eliminated = 1;
+    }
+  }
+
+  return best;
+}
+
+static int countRemaining(struct candidate* candidates, int numberCandidates) {
+  int count = 0;
+
+  for (int i = 0; i < numberCandidates; i++) {
+    count += !candidates[i].eliminated;
+  }
+
+  return count;
+}
+
+int searchStrategies(struct market* market,
+                     struct candidate* candidates,
+                     int numberCandidates,
+                     struct searchParameters* parameters) {
+  if (market->size > MAX_OUTCOMES + 1) {
+    return -1;
+  }
+
+  int tasksPerCandidate = (parameters->gamesPerRound + parameters->gamesPerTask - 1)
+    / parameters->gamesPerTask;
+  struct workPool* pool = createWorkPool(parameters->numberWorkers);
+  struct outcomeTable* table = createOutcomeTable(market->size);
+  struct searchTask* tasks = calloc((long) numberCandidates * tasksPerCandidate, sizeof(struct searchTask));
+  double* profits = calloc((long) numberCandidates * parameters->gamesPerRound, sizeof(double));
+  int best = 0;
+
+  for (int round = 0; round < parameters->maxRounds; round++) {
+    simulateRound(pool,
+                  market,
+                  table,
+                  candidates,
+                  numberCandidates,
+                  parameters,
+                  tasks,
+                  (long) round * parameters->gamesPerRound,
+                  profits);
+    best = eliminateCandidates(candidates, numberCandidates, parameters, profits);
+
+    if (countRemaining(candidates, numberCandidates) == 1) {
+      break;
+    }
+  }
+
+  freeWorkPool(pool);
+  freeOutcomeTable(table);
+  free(tasks);
+  free(profits);
+
+  return best;
+}
@@ -0,0 +1,48 @@
+// Search for the best parameters of the strategy in simulate.h, by
+// simulating every candidate on the same games, in parallel, round by
+// round. After each round, candidates which are clearly worse than
+// the best one are eliminated and not simulated any further.
+
+#include "simulate.h"
+
+struct candidate {
+  struct strategy strategy;
+  int eliminated;
+  long numberGames;
+  double sum;
+  double mean;
+  double standardError;
+};
+
+struct searchParameters {
+  int numberWorkers;
+  int gamesPerRound;
+  int gamesPerTask;
+  int maxRounds;
+  // Eliminate a candidate once its mean profit is below that of the
+  // best candidate by this many standard errors of the difference.
+  double eliminationStandardErrors;
+};
+
+// Create a candidate for every combination of the given edge
+// thresholds and outcome masks. Every bet is settled on its own, so
+// the profit of a strategy is proportional to its stake fraction, and
+// the stake fraction would not change which candidate is best. Every
+// candidate therefore stakes the same `stakeFraction`.
+struct candidate* createCandidateGrid(double commission,
+                                      double stakeFraction,
+                                      int* edgeThresholdTicks,
+                                      int numberThresholds,
+                                      unsigned long* outcomeMasks,
+                                      int numberMasks,
+                                      int* numberCandidates);
+
+void freeCandidates(struct candidate* candidates);
+
+// Run the search, leaving the results in `candidates`. Returns the
+// index of the best candidate, or -1 if the market is dealt from more
+// than (MAX_OUTCOMES + 1) cards.
+int searchStrategies(struct market* market,
+                     struct candidate* candidates,
+                     int numberCandidates,
+                     struct searchParameters* parameters);
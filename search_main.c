@@ -0,0 +1,52 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "pool.h"
+#include "search.h"
+
+#define COMMISSION 0.03
+#define STAKE_FRACTION 0.01
+
+// Search over a grid of strategies for the 13 card game against a
+// market of participants paying COMMISSION, whose quotes are noisy.
+// Run as `search [number_workers]`. The mean profit per game of each
+// candidate is printed, as a fraction of our bankroll, with its
+// standard error against the best candidate and the number of games it
+// was simulated on before it was eliminated or the search ended. The
+// best candidate is marked with *.
+int main(int argc, char** argv) {
+  int edgeThresholdTicks[] = { 0, 1, 2, 3, 5, 8 };
+  unsigned long outcomeMasks[] = { 0xfff, 0x00f, 0x0f0, 0xf00 };
+  struct market market = { 13, 0, COMMISSION, 0, 4, 0x48694c6f };
+  struct searchParameters parameters = { getNumberProcessors(), 20000, 2000, 50, 3.0 };
+  int numberCandidates;
+
+  if (argc > 1) {
+    parameters.numberWorkers = atoi(argv[1]);
+  }
+
+  struct candidate* candidates = createCandidateGrid(COMMISSION,
+                                                     STAKE_FRACTION,
+                                                     edgeThresholdTicks,
+                                                     sizeof(edgeThresholdTicks) / sizeof(int),
+                                                     outcomeMasks,
+                                                     sizeof(outcomeMasks) / sizeof(unsigned long),
+                                                     &numberCandidates);
+  int best = searchStrategies(&market, candidates, numberCandidates, &parameters);
+
+  for (int i = 0; i < numberCandidates; i++) {
+    struct strategy* strategy = &candidates[i].strategy;
+
+    printf("%s T: %d -- F: %.3f -- M: %03lx -- G: %ld -- P: %+.6f -- E: %.6f\n",
+           i == best ? "*" : " ",
+           strategy->edgeThresholdTicks,
+           strategy->stakeFraction,
+           strategy->outcomeMask,
+           candidates[i].numberGames,
+           candidates[i].mean,
+           candidates[i].standardError);
+  }
+
+  freeCandidates(candidates);
+
+  return 0;
+}
@@ -0,0 +1,154 @@
+#include <stdlib.h>
+#include "prob.h"
+#include "state.h"
+#include "sized.h"
+#include "session.h"
+
+// From the state (size, numberLower), the next card leads to one of
+// the `size` states (size - 1, position), one for each position of the
+// card among the remaining cards. These are computed by a worker
+// thread started when the betting window opens, into the half of
+// `children` not holding the current state. Dealing waits for the
+// worker, which has normally long finished, and points the current
+// state at the child for the dealt card.
+
+static void initialisePricedState(struct pricedState* state, int maxSize) {
+  int length = getLengthOfProbabilities(maxSize);
+
+  state->numerators = createProbabilitiesResult(maxSize);
+  state->denominators = createProbabilitiesResult(maxSize);
+  state->probabilities = calloc(length, sizeof(double));
+}
+
+static void clearPricedState(struct pricedState* state) {
+  freeProbabilitiesResult(state->numerators);
+  freeProbabilitiesResult(state->denominators);
+  free(state->probabilities);
+}
+
+// Decks of fewer than two cards have no outcomes left to bet on.
+static void pricePricedState(struct pricedState* state, int size, int numberLower, int correct) {
+  state->size = size;
+  state->numberLower = numberLower;
+  state->correct = correct;
+  state->numberOutcomes = correct && size >= 2 ? getLengthOfProbabilities(size) : 0;
+
+  if (state->numberOutcomes == 0) {
+    return;
+  }
+
+  calculateSizedProbabilities(state->numerators, state->denominators, size, numberLower);
+
+  for (int i = 0; i < state->numberOutcomes; i++) {
+    state->probabilities[i] = (double) state->numerators[i] / (double) state->denominators[i];
+  }
+}
+
+struct session* createSession(int maxSize) {
+  if (maxSize > MAX_SIZED_SIZE) {
+    return NULL;
+  }
+
+  struct session* session = malloc(sizeof(struct session));
+
+  session->maxSize = maxSize;
+  session->over = 1;
+  session->current = &session->root;
+  session->filling = 0;
+  session->precomputing = 0;
+
+  initialisePricedState(&session->root, maxSize);
+
+  for (int i = 0; i < 2; i++) {
+    session->children[i] = calloc(maxSize, sizeof(struct pricedState));
+
+    for (int position = 0; position < maxSize; position++) {
+      initialisePricedState(&session->children[i][position], maxSize);
+    }
+  }
+
+  return session;
+}
+
+static void waitForChildren(struct session* session) {
+  if (session->precomputing) {
+    pthread_join(session->worker, NULL);
+    session->precomputing = 0;
+  }
+}
+
+void freeSession(struct session* session) {
+  waitForChildren(session);
+  clearPricedState(&session->root);
+
+  for (int i = 0; i < 2; i++) {
+    for (int position = 0; position < session->maxSize; position++) {
+      clearPricedState(&session->children[i][position]);
+    }
+
+    free(session->children[i]);
+  }
+
+  free(session);
+}
+
+static void* precomputeChildren(void* argument) {
+  struct session* session = argument;
+  struct pricedState* current = session->current;
+  struct pricedState* children = session->children[session->filling];
+
+  for (int position = 0; position < current->size; position++) {
+    int correct = isCorrectPrediction(current->size, current->numberLower, position);
+
+    pricePricedState(&children[position], current->size - 1, position, correct);
+  }
+
+  return NULL;
+}
+
+// Start computing the children of the current state, unless the game
+// is over.
+static void openBettingWindow(struct session* session) {
+  session->over = session->current->numberOutcomes == 0;
+
+  if (!session->over) {
+    session->precomputing = pthread_create(&session->worker, NULL, precomputeChildren, session) == 0;
+
+    if (!session->precomputing) {
+      precomputeChildren(session);
+    }
+  }
+}
+
+void startSession(struct session* session, int size, int numberLower) {
+  waitForChildren(session);
+
+  session->current = &session->root;
+  session->filling = 0;
+  pricePricedState(session->current, size, numberLower, 1);
+
+  openBettingWindow(session);
+}
+
+struct pricedState* getSessionPrices(struct session* session) {
+  return session->current;
+}
+
+struct pricedState* dealSession(struct session* session, int position) {
+  if (session->over) {
+    return session->current;
+  }
+
+  if (position < 0 || position >= session->current->size) {
+    return NULL;
+  }
+
+  waitForChildren(session);
+
+  session->current = &session->children[session->filling][position];
+  session->filling = 1 - session->filling;
+
+  openBettingWindow(session);
+
+  return session->current;
+}
@@ -0,0 +1,52 @@
+#include <pthread.h>
+
+// A pricing session follows one game, and keeps the exact
+// probabilities of its open outcomes (see prob.h). While the betting
+// window of a stage is open, the probabilities after every card which
+// could be dealt next are computed in the background. Dealing a card
+// then only switches to the probabilities already computed for it.
+
+struct pricedState {
+  int size;
+  int numberLower;
+  // Whether the computer predicted the deal leading here correctly.
+  // Once a prediction fails, there are no open outcomes left.
+  int correct;
+  int numberOutcomes;
+  unsigned long int* numerators;
+  unsigned long int* denominators;
+  double* probabilities;
+};
+
+struct session {
+  int maxSize;
+  int over;
+  struct pricedState* current;
+  struct pricedState root;
+  // The states after each possible next card, for this stage and the
+  // last, filled in turns, so that the current state is never
+  // overwritten.
+  struct pricedState* children[2];
+  int filling;
+  pthread_t worker;
+  int precomputing;
+};
+
+// Returns NULL if `maxSize` is more than MAX_SIZED_SIZE (see sized.h),
+// as states are priced by the solvers specialised to their size.
+struct session* createSession(int maxSize);
+
+void freeSession(struct session* session);
+
+// Start following a game in the state (size, numberLower), and start
+// computing the prices after the next deal.
+void startSession(struct session* session, int size, int numberLower);
+
+// The prices in the current state.
+struct pricedState* getSessionPrices(struct session* session);
+
+// Deal the card which has `position` remaining cards lower than it,
+// and return the prices in the state it leads to. Returns NULL, and
+// stays in the current state, if `position` is not that of a remaining
+// card, from 0 up to the size of the current state less 1.
+struct pricedState* dealSession(struct session* session, int position);
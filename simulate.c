@@ -0,0 +1,130 @@
+#include "prob.h"
+#include "odds.h"
+#include "rng.h"
+#include "state.h"
+#include "simulate.h"
+
+// At each betting window we look at every open outcome. The outcome at
+// index n of the starting state is still open after d correct
+// predictions if n >= d, and it then needs the next (n + 1 - d) deals
+// to be predicted correctly. Its fair probability is the outcome at
+// index (n - d) of the current state.
+//
+// The market's quotes for every open outcome are drawn at each window
+// whether or not the strategy trades that outcome, so that the random
+// stream does not depend on the strategy.
+
+// Draw a number of ticks between -noiseTicks and noiseTicks.
+static int drawNoise(struct randomState* random, int noiseTicks) {
+  return nextRandomBelow(random, 2 * noiseTicks + 1) - noiseTicks;
+}
+
+// The profit of a stake of 1 backed or laid at `ticks`.
+static double settleBet(int lay, int ticks, int won, double commission) {
+  double odds = (double) ticks / TICKS_IN_UNIT;
+  double backProfit = won ? (odds - 1) * (1 - commission) : -1;
+  double layProfit = won ? -(odds - 1) : 1 - commission;
+
+  return lay ? layProfit : backProfit;
+}
+
+// Simulate one game, returning the profit for a bankroll of 1.
+static double simulateGame(struct market* market,
+                           struct strategy* strategy,
+                           struct outcomeTable* table,
+                           struct randomState* random) {
+  int numberOutcomes = getLengthOfProbabilities(market->size);
+  double backStakes[MAX_OUTCOMES] = { 0 };
+  double layStakes[MAX_OUTCOMES] = { 0 };
+  double backWinnings[MAX_OUTCOMES] = { 0 };
+  double layLiabilities[MAX_OUTCOMES] = { 0 };
+  int size = market->size;
+  int numberLower = market->numberLower;
+  int streak = 0;
+  int failed = 0;
+
+  while (size > 1 && !failed) {
+    double* probabilities = getOutcomeProbabilities(table, size, numberLower);
+
+    for (int n = streak; n < numberOutcomes; n++) {
+      double probability = probabilities[n - streak];
+      int backTicks;
+      int layTicks;
+
+      modelMarketTicks(probability, market->marketCommission, market->offsetTicks, &backTicks, &layTicks);
+
+      // The noise is drawn even for a side with no quote, so that the
+      // stream stays the same for every strategy.
+      int backNoise = drawNoise(random, market->noiseTicks);
+      int layNoise = drawNoise(random, market->noiseTicks);
+
+      backTicks = backTicks == NO_ODDS_TICKS ? NO_ODDS_TICKS : backTicks + backNoise;
+      layTicks = layTicks == NO_ODDS_TICKS ? NO_ODDS_TICKS : layTicks + layNoise;
+
+      if (!(strategy->outcomeMask & (1UL << n)) || probability <= 0 || probability >= 1) {
+        continue;
+      }
+
+      int ourBackTicks = calculateTightestBackTicks(probability, strategy->commission);
+      int ourLayTicks = calculateTightestLayTicks(probability, strategy->commission);
+
+      if (backTicks >= MIN_ODDS_TICKS
+          && ourBackTicks != NO_ODDS_TICKS
+          && backTicks - ourBackTicks >= strategy->edgeThresholdTicks) {
+        backStakes[n] += strategy->stakeFraction;
+        backWinnings[n] += strategy->stakeFraction * settleBet(0, backTicks, 1, strategy->commission);
+      }
+
+      if (layTicks >= MIN_ODDS_TICKS
+          && ourLayTicks != NO_ODDS_TICKS
+          && ourLayTicks - layTicks >= strategy->edgeThresholdTicks) {
+        layStakes[n] += strategy->stakeFraction;
+        layLiabilities[n] += strategy->stakeFraction * settleBet(1, layTicks, 1, strategy->commission);
+      }
+    }
+
+    int position = nextRandomBelow(random, size);
+
+    if (isCorrectPrediction(size, numberLower, position)) {
+      streak++;
+    } else {
+      failed = 1;
+    }
+
+    size--;
+    numberLower = position;
+  }
+
+  double profit = 0;
+
+  for (int n = 0; n < numberOutcomes; n++) {
+    if (streak >= n + 1) {
+      profit += backWinnings[n] + layLiabilities[n];
+    } else {
+      profit += -backStakes[n] + layStakes[n] * (1 - strategy->commission);
+    }
+  }
+
+  return profit;
+}
+
+int simulateGames(struct market* market,
+                  struct strategy* strategy,
+                  struct outcomeTable* table,
+                  long firstGame,
+                  int numberGames,
+                  double* profits) {
+  struct randomState random;
+
+  if (market->size > MAX_OUTCOMES + 1) {
+    return 0;
+  }
+
+  for (int i = 0; i < numberGames; i++) {
+    seedRandom(&random, market->seed ^ ((firstGame + i) * 0xd1342543de82ef95));
+    nextRandom(&random);
+    profits[i] = simulateGame(market, strategy, table, &random);
+  }
+
+  return 1;
+}
@@ -0,0 +1,47 @@
+// Simulate trading a simple strategy on many games against a modelled
+// market. Each game is dealt from the state (size, numberLower), and
+// its deals and market prices are drawn from a random stream seeded by
+// `seed` and the index of the game alone. Every strategy therefore
+// sees exactly the same games, which makes the differences between
+// strategies far less noisy than their results.
+
+// The most outcomes a game can have, given that masks are unsigned
+// longs. A market may therefore be dealt from at most
+// (MAX_OUTCOMES + 1) cards.
+#define MAX_OUTCOMES 64
+
+struct market {
+  int size;
+  int numberLower;
+  // The market quotes as in `modelMarketTicks` in odds.h, each quote
+  // moved by up to `noiseTicks` ticks in either direction at random.
+  double marketCommission;
+  int offsetTicks;
+  int noiseTicks;
+  unsigned long seed;
+};
+
+struct strategy {
+  // The commission we pay on winnings.
+  double commission;
+  // Back or lay only when the market's price is at least this many
+  // ticks better than our tightest profitable odds.
+  int edgeThresholdTicks;
+  // The stake of each bet, as a fraction of our bankroll.
+  double stakeFraction;
+  // Bit n is set to trade the outcome at index n of the starting state.
+  unsigned long outcomeMask;
+};
+
+struct outcomeTable;
+
+// The profit of the strategy on each of the games numbered from
+// `firstGame` to (firstGame + numberGames - 1), as a fraction of our
+// bankroll. Returns 0, simulating nothing, if the market is dealt from
+// more than (MAX_OUTCOMES + 1) cards, and 1 otherwise.
+int simulateGames(struct market* market,
+                   struct strategy* strategy,
+                   struct outcomeTable* table,
+                   long firstGame,
+                   int numberGames,
+                   double* profits);
@@ -0,0 +1,83 @@
+#include "prob.h"
+#include "state.h"
+#include "paths.h"
+#include "sized.h"
+
+// A solver is generated for each deck size by the macro below, from
+// the path counting of paths.h. Within it, `SIZE` is a constant, so
+// every loop has a trip count known at compile time and is fully
+// unrolled, and the rows live on the stack. For the standard game of
+// 13 cards, the whole solve is straight line code apart from finding
+// where the computer's predictions change and reducing the results to
+// lowest terms.
+
+DEFINE_PATH_DEAL(dealPaths, unsigned long int)
+
+#define DEFINE_SIZED_SOLVER(SIZE)                                                   \
+  static void calculateProbabilities##SIZE(unsigned long int* numeratorsResult,     \
+                                           unsigned long int* denominatorsResult,   \
+                                           int numberLower) {                       \
+    unsigned long int paths[SIZE + 1] = { 0 };                                      \
+    unsigned long int prefixSums[SIZE + 2];                                         \
+    unsigned long int numberDeals = 1;                                              \
+                                                                                    \
+    paths[numberLower] = 1;                                                         \
+                                                                                    \
+    _Pragma("GCC unroll 32")                                                        \
+    for (int n = 0; n < SIZE - 1; n++) {                                            \
+      unsigned long int sum = dealPaths(paths, prefixSums, SIZE - n);               \
+                                                                                    \
+      numberDeals *= SIZE - n;                                                      \
+      reducePathCount(&numeratorsResult[n], &denominatorsResult[n], sum, numberDeals); \
+    }                                                                               \
+  }
+
+DEFINE_SIZED_SOLVER(2)
+DEFINE_SIZED_SOLVER(3)
+DEFINE_SIZED_SOLVER(4)
+DEFINE_SIZED_SOLVER(5)
+DEFINE_SIZED_SOLVER(6)
+DEFINE_SIZED_SOLVER(7)
+DEFINE_SIZED_SOLVER(8)
+DEFINE_SIZED_SOLVER(9)
+DEFINE_SIZED_SOLVER(10)
+DEFINE_SIZED_SOLVER(11)
+DEFINE_SIZED_SOLVER(12)
+DEFINE_SIZED_SOLVER(13)
+DEFINE_SIZED_SOLVER(14)
+DEFINE_SIZED_SOLVER(15)
+DEFINE_SIZED_SOLVER(16)
+DEFINE_SIZED_SOLVER(17)
+DEFINE_SIZED_SOLVER(18)
+DEFINE_SIZED_SOLVER(19)
+DEFINE_SIZED_SOLVER(20)
+
+typedef void (*sizedSolver)(unsigned long int*, unsigned long int*, int);
+
+// The solvers indexed by size. Decks of fewer than two cards have no
+// outcomes, and have no solver.
+static const sizedSolver sizedSolvers[MAX_SIZED_SIZE + 1] = {
+  0, 0,
+  calculateProbabilities2, calculateProbabilities3, calculateProbabilities4,
+  calculateProbabilities5, calculateProbabilities6, calculateProbabilities7,
+  calculateProbabilities8, calculateProbabilities9, calculateProbabilities10,
+  calculateProbabilities11, calculateProbabilities12, calculateProbabilities13,
+  calculateProbabilities14, calculateProbabilities15, calculateProbabilities16,
+  calculateProbabilities17, calculateProbabilities18, calculateProbabilities19,
+  calculateProbabilities20
+};
+
+int calculateSizedProbabilities(unsigned long int* numeratorsResult,
+                                unsigned long int* denominatorsResult,
+                                int size,
+                                int numberLower) {
+  if (size > MAX_SIZED_SIZE) {
+    return 0;
+  }
+
+  if (size >= 2) {
+    sizedSolvers[size](numeratorsResult, denominatorsResult, numberLower);
+  }
+
+  return 1;
+}
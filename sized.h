@@ -0,0 +1,13 @@
+// The largest deck with a solver specialised to its size. Up to this
+// size, every count fits in 64 bits.
+#define MAX_SIZED_SIZE 20
+
+// The same as `calculateProbabilities` in prob.h, but solved by a
+// solver specialised to `size`, whose loops all have trip counts
+// known when it is compiled. Returns 0, and computes nothing, for a
+// deck of more than MAX_SIZED_SIZE cards, whose probabilities need not
+// fit in 64 bits (see prob128.h for those).
+int calculateSizedProbabilities(unsigned long int* numeratorsResult,
+                                unsigned long int* denominatorsResult,
+                                int size,
+                                int numberLower);
@@ -0,0 +1,362 @@
+#include <stdlib.h>
+#include "prob.h"
+#include "state.h"
+#include "spec.h"
+#include "paths.h"
+
+// The rules of the game only matter through which deals the computer
+// predicts correctly. Predicting higher from the state (m, i) is
+// correct for the deals leading to (m - 1, j) with j >= i, and
+// predicting lower for those with j < i, so for any of the dealer
+// policies the correct deals form a single range of j. Compiling a
+// spec works out that range for every state once.
+//
+// The engine then deals one card at a time, as in prob128.c, carrying
+// a row of the number of ways to reach each state. Each state adds its
+// ways to a range of the next row, which is done with a difference
+// array, so that every deal takes time linear in the number of
+// states whatever the rules.
+//
+// For streaks, only correct deals are carried on, and the outcome at
+// index n is the sum of the row after (n + 1) deals. For totals, every
+// deal is carried on, with the row split by the number of correct
+// predictions so far, and the outcomes are the tails of the
+// distribution of that number once every deal is done.
+
+static int predictsHigherBySpec(struct gameSpec* spec, int m, int i) {
+  int numberHigher = m - i;
+
+  switch (spec->dealerPolicy) {
+  case DEALER_POLICY_ALWAYS_HIGHER:
+    return 1;
+  case DEALER_POLICY_ALWAYS_LOWER:
+    return 0;
+  }
+
+  if (numberHigher == i) {
+    return spec->tieRule == TIE_RULE_HIGHER;
+  }
+
+  int moreHigher = numberHigher > i;
+
+  return spec->dealerPolicy == DEALER_POLICY_CONTRARIAN ? !moreHigher : moreHigher;
+}
+
+static int isValidSpec(struct gameSpec* spec) {
+  return spec->size >= 1
+    && spec->dealerPolicy >= DEALER_POLICY_STANDARD && spec->dealerPolicy <= DEALER_POLICY_ALWAYS_LOWER
+    && (spec->tieRule == TIE_RULE_HIGHER || spec->tieRule == TIE_RULE_LOWER)
+    && (spec->outcomeKind == OUTCOME_STREAK || spec->outcomeKind == OUTCOME_TOTAL);
+}
+
+struct compiledGame* compileGame(struct gameSpec* spec) {
+  if (!isValidSpec(spec)) {
+    return NULL;
+  }
+
+  struct compiledGame* game = malloc(sizeof(struct compiledGame));
+  int numberStates = getNumberStates(spec->size);
+
+  game->spec = *spec;
+  game->correctStarts = calloc(numberStates, sizeof(int));
+  game->correctEnds = calloc(numberStates, sizeof(int));
+
+  for (int m = 1; m <= spec->size; m++) {
+    for (int i = 0; i <= m; i++) {
+      int k = getStateIndex(m, i);
+
+      if (predictsHigherBySpec(spec, m, i)) {
+        game->correctStarts[k] = i;
+        game->correctEnds[k] = m;
+      } else {
+        game->correctStarts[k] = 0;
+        game->correctEnds[k] = i;
+      }
+    }
+  }
+
+  return game;
+}
+
+void freeCompiledGame(struct compiledGame* game) {
+  free(game->correctStarts);
+  free(game->correctEnds);
+  free(game);
+}
+
+// Add `ways` to the entries of a row in [start, end), recorded in the
+// difference array `differences`. Counts are unsigned, and the
+// differences may wrap around, but the sums they come back to do not.
+static void addToRange(unsigned long int* differences, int start, int end, unsigned long int ways) {
+  differences[start] += ways;
+  differences[end] -= ways;
+}
+
+static void calculateStreakProbabilities(struct compiledGame* game,
+                                         unsigned long int* numeratorsResult,
+                                         unsigned long int* denominatorsResult,
+                                         int size,
+                                         int numberLower) {
+  unsigned long int row[MAX_SPEC_SIZE + 1] = { 0 };
+  unsigned long int differences[MAX_SPEC_SIZE + 1] = { 0 };
+  unsigned long int numberDeals = 1;
+
+  row[numberLower] = 1;
+
+  for (int n = 0; n < getLengthOfProbabilities(size); n++) {
+    int m = size - n;
+    int* correctStarts = &game->correctStarts[getStateIndex(m, 0)];
+    int* correctEnds = &game->correctEnds[getStateIndex(m, 0)];
+
+    for (int i = 0; i <= m; i++) {
+      addToRange(differences, correctStarts[i], correctEnds[i], row[i]);
+    }
+
+    unsigned long int ways = 0;
+    unsigned long int sum = 0;
+
+    for (int j = 0; j <= m; j++) {
+      ways += differences[j];
+      differences[j] = 0;
+      row[j] = ways;
+      sum += ways;
+    }
+
+    numberDeals *= m;
+    reducePathCount(&numeratorsResult[n], &denominatorsResult[n], sum, numberDeals);
+  }
+}
+
+// The rows are indexed by [c * (size + 1) + i], for c correct
+// predictions so far in the state with i cards lower.
+static void calculateTotalProbabilities(struct compiledGame* game,
+                                        unsigned long int* numeratorsResult,
+                                        unsigned long int* denominatorsResult,
+                                        int size,
+                                        int numberLower) {
+  int length = getLengthOfProbabilities(size);
+  int width = size + 1;
+  unsigned long int row[MAX_SPEC_SIZE * (MAX_SPEC_SIZE + 1)] = { 0 };
+  unsigned long int differences[MAX_SPEC_SIZE * (MAX_SPEC_SIZE + 1)] = { 0 };
+  unsigned long int numberDeals = 1;
+
+  row[numberLower] = 1;
+
+  for (int n = 0; n < length; n++) {
+    int m = size - n;
+    int* correctStarts = &game->correctStarts[getStateIndex(m, 0)];
+    int* correctEnds = &game->correctEnds[getStateIndex(m, 0)];
+
+    for (int c = 0; c <= n; c++) {
+      for (int i = 0; i <= m; i++) {
+        unsigned long int ways = row[c * width + i];
+        int start = correctStarts[i];
+        int end = correctEnds[i];
+
+        if (ways == 0) {
+          continue;
+        }
+
+        addToRange(&differences[(c + 1) * width], start, end, ways);
+        addToRange(&differences[c * width], 0, start, ways);
+        addToRange(&differences[c * width], end, m, ways);
+      }
+    }
+
+    for (int c = 0; c <= n + 1; c++) {
+      unsigned long int ways = 0;
+
+      for (int j = 0; j <= m; j++) {
+        ways += differences[c * width + j];
+        differences[c * width + j] = 0;
+        row[c * width + j] = ways;
+      }
+    }
+
+    numberDeals *= m;
+  }
+
+  // At least (n + 1) correct predictions in total.
+  unsigned long int tail = 0;
+
+  for (int n = length - 1; n >= 0; n--) {
+    for (int j = 0; j < width; j++) {
+      tail += row[(n + 1) * width + j];
+    }
+
+    reducePathCount(&numeratorsResult[n], &denominatorsResult[n], tail, numberDeals);
+  }
+}
+
+// The exact engines keep their rows on the stack, with room for decks
+// of up to MAX_SPEC_SIZE cards, so larger decks are rejected here.
+int calculateSpecProbabilities(struct compiledGame* game,
+                               unsigned long int* numeratorsResult,
+                               unsigned long int* denominatorsResult,
+                               int size,
+                               int numberLower) {
+  if (size > MAX_SPEC_SIZE || size > game->spec.size) {
+    return 0;
+  }
+
+  if (game->spec.outcomeKind == OUTCOME_TOTAL) {
+    calculateTotalProbabilities(game, numeratorsResult, denominatorsResult, size, numberLower);
+  } else {
+    calculateStreakProbabilities(game, numeratorsResult, denominatorsResult, size, numberLower);
+  }
+
+  return 1;
+}
+
+// The same engine in double precision. The rows hold probabilities
+// rather than counts, and each deal divides by the number of cards it
+// could have dealt. The rows are kept in a workspace which can be
+// reused from one solve to the next, so that no solve allocates.
+
+// The number of values in the rows for a deck of `size` cards. Totals
+// take a row for each number of correct predictions, from 0 up to
+// getLengthOfProbabilities(size).
+static long getRowsLength(int size, int outcomeKind) {
+  return (outcomeKind == OUTCOME_TOTAL ? size : 1) * (long) (size + 1);
+}
+
+struct specWorkspace* createSpecWorkspace(int maxSize, int outcomeKind) {
+  struct specWorkspace* workspace = malloc(sizeof(struct specWorkspace));
+  long length = getRowsLength(maxSize, outcomeKind);
+
+  workspace->maxSize = maxSize;
+  workspace->outcomeKind = outcomeKind;
+  workspace->row = calloc(length, sizeof(double));
+  workspace->differences = calloc(length, sizeof(double));
+
+  return workspace;
+}
+
+void freeSpecWorkspace(struct specWorkspace* workspace) {
+  free(workspace->row);
+  free(workspace->differences);
+  free(workspace);
+}
+
+static void addToApproximateRange(double* differences, int start, int end, double probability) {
+  differences[start] += probability;
+  differences[end] -= probability;
+}
+
+static void calculateApproximateStreakProbabilities(struct compiledGame* game,
+                                                    struct specWorkspace* workspace,
+                                                    double* probabilitiesResult,
+                                                    int size,
+                                                    int numberLower) {
+  double* row = workspace->row;
+  double* differences = workspace->differences;
+
+  for (int i = 0; i <= size; i++) {
+    row[i] = i == numberLower;
+    differences[i] = 0;
+  }
+
+  for (int n = 0; n < getLengthOfProbabilities(size); n++) {
+    int m = size - n;
+    int* correctStarts = &game->correctStarts[getStateIndex(m, 0)];
+    int* correctEnds = &game->correctEnds[getStateIndex(m, 0)];
+
+    for (int i = 0; i <= m; i++) {
+      addToApproximateRange(differences, correctStarts[i], correctEnds[i], row[i] / m);
+    }
+
+    double probability = 0;
+    double sum = 0;
+
+    for (int j = 0; j <= m; j++) {
+      probability += differences[j];
+      differences[j] = 0;
+      row[j] = probability;
+      sum += probability;
+    }
+
+    probabilitiesResult[n] = sum;
+  }
+}
+
+static void calculateApproximateTotalProbabilities(struct compiledGame* game,
+                                                   struct specWorkspace* workspace,
+                                                   double* probabilitiesResult,
+                                                   int size,
+                                                   int numberLower) {
+  int length = getLengthOfProbabilities(size);
+  int width = size + 1;
+  double* row = workspace->row;
+  double* differences = workspace->differences;
+
+  for (int i = 0; i < width * (length + 1); i++) {
+    row[i] = i == numberLower;
+    differences[i] = 0;
+  }
+
+  for (int n = 0; n < length; n++) {
+    int m = size - n;
+    int* correctStarts = &game->correctStarts[getStateIndex(m, 0)];
+    int* correctEnds = &game->correctEnds[getStateIndex(m, 0)];
+
+    for (int c = 0; c <= n; c++) {
+      for (int i = 0; i <= m; i++) {
+        double probability = row[c * width + i] / m;
+        int start = correctStarts[i];
+        int end = correctEnds[i];
+
+        if (probability == 0) {
+          continue;
+        }
+
+        addToApproximateRange(&differences[(c + 1) * width], start, end, probability);
+        addToApproximateRange(&differences[c * width], 0, start, probability);
+        addToApproximateRange(&differences[c * width], end, m, probability);
+      }
+    }
+
+    for (int c = 0; c <= n + 1; c++) {
+      double probability = 0;
+
+      for (int j = 0; j <= m; j++) {
+        probability += differences[c * width + j];
+        differences[c * width + j] = 0;
+        row[c * width + j] = probability;
+      }
+    }
+  }
+
+  double tail = 0;
+
+  for (int n = length - 1; n >= 0; n--) {
+    for (int j = 0; j < width; j++) {
+      tail += row[(n + 1) * width + j];
+    }
+
+    probabilitiesResult[n] = tail;
+  }
+}
+
+// A workspace for totals also has room for the single row of a streak
+// of a much larger deck, so the rows are checked by their length
+// rather than by the kind and size of the workspace.
+int calculateApproximateSpecProbabilities(struct compiledGame* game,
+                                          struct specWorkspace* workspace,
+                                          double* probabilitiesResult,
+                                          int size,
+                                          int numberLower) {
+  int outcomeKind = game->spec.outcomeKind;
+
+  if (size > game->spec.size
+      || getRowsLength(size, outcomeKind) > getRowsLength(workspace->maxSize, workspace->outcomeKind)) {
+    return 0;
+  }
+
+  if (outcomeKind == OUTCOME_TOTAL) {
+    calculateApproximateTotalProbabilities(game, workspace, probabilitiesResult, size, numberLower);
+  } else {
+    calculateApproximateStreakProbabilities(game, workspace, probabilitiesResult, size, numberLower);
+  }
+
+  return 1;
+}
@@ -0,0 +1,84 @@
+// A declarative description of a Hi-Lo style game, compiled into a
+// table of which deals the computer predicts correctly from each
+// state, and priced by a generic dynamic algorithm. Decks are of
+// distinct ranks, so that a state is still characterised by `size`
+// and `numberLower`, and the outcomes are, as in prob.c, indexed by
+// n for getLengthOfProbabilities(size) values of n.
+
+// How the computer chooses its prediction. The standard dealer
+// predicts whichever of higher or lower has more cards left, and the
+// contrarian one whichever has fewer.
+#define DEALER_POLICY_STANDARD 0
+#define DEALER_POLICY_CONTRARIAN 1
+#define DEALER_POLICY_ALWAYS_HIGHER 2
+#define DEALER_POLICY_ALWAYS_LOWER 3
+
+// What the computer predicts when as many cards are higher as lower.
+#define TIE_RULE_HIGHER 0
+#define TIE_RULE_LOWER 1
+
+// The outcome at index n is either that the next (n + 1) deals are
+// all predicted correctly, as in the standard game, or that at least
+// (n + 1) of the deals left are predicted correctly in total.
+#define OUTCOME_STREAK 0
+#define OUTCOME_TOTAL 1
+
+// The largest deck whose counts fit in 64 bits, for the exact engine.
+// The double precision engine takes decks of any size.
+#define MAX_SPEC_SIZE 20
+
+struct gameSpec {
+  int size;
+  int dealerPolicy;
+  int tieRule;
+  int outcomeKind;
+};
+
+// For every state (m, i) with at most `spec.size` cards left, the
+// computer's prediction is correct exactly for the deals leading to
+// the states (m - 1, j) with j in [correctStarts[k], correctEnds[k]),
+// where k = getStateIndex(m, i).
+struct compiledGame {
+  struct gameSpec spec;
+  int* correctStarts;
+  int* correctEnds;
+};
+
+// Returns NULL if the spec has no cards, or a rule other than those
+// above.
+struct compiledGame* compileGame(struct gameSpec* spec);
+
+void freeCompiledGame(struct compiledGame* game);
+
+// The exact probabilities of the outcomes from the state
+// (size, numberLower), as in `calculateProbabilities`. Returns 0, and
+// computes nothing, if `size` is more than the size of the spec or
+// than MAX_SPEC_SIZE.
+int calculateSpecProbabilities(struct compiledGame* game,
+                               unsigned long int* numeratorsResult,
+                               unsigned long int* denominatorsResult,
+                               int size,
+                               int numberLower);
+
+// Room for the rows of the double precision engine, for decks of up
+// to `maxSize` cards with outcomes of the kind `outcomeKind`.
+struct specWorkspace {
+  int maxSize;
+  int outcomeKind;
+  double* row;
+  double* differences;
+};
+
+struct specWorkspace* createSpecWorkspace(int maxSize, int outcomeKind);
+
+void freeSpecWorkspace(struct specWorkspace* workspace);
+
+// The same probabilities in double precision, for a deck of any size
+// up to the size of the spec. Returns 0, and computes nothing, if the
+// workspace has no room for the rows of the deck, which for totals
+// take a row per number of correct predictions.
+int calculateApproximateSpecProbabilities(struct compiledGame* game,
+                                          struct specWorkspace* workspace,
+                                          double* probabilitiesResult,
+                                          int size,
+                                          int numberLower);
@@ -0,0 +1,117 @@
+#include <stdlib.h>
+#include "prob.h"
+#include "state.h"
+
+// A card with `position` remaining cards lower than it is higher than
+// the last played card exactly when `position` >= `numberLower`. This
+// is the same case split as in `initialiseFirstStage` in prob.c.
+int isCorrectPrediction(int size, int numberLower, int position) {
+  if (predictsHigher(size, numberLower)) {
+    return position >= numberLower;
+  } else {
+    return position < numberLower;
+  }
+}
+
+// There are (size + 1) states for each `size`, one for each value of
+// `numberLower`, so the states of a smaller `size` take up
+// 1 + 2 + ... + size places.
+int getStateIndex(int size, int numberLower) {
+  return (size * (size + 1)) / 2 + numberLower;
+}
+
+int getNumberStates(int maxSize) {
+  return getStateIndex(maxSize + 1, 0);
+}
+
+// Decks with fewer than two cards have no outcomes left to bet on.
+static int getNumberOutcomes(int size) {
+  return size < 2 ? 0 : getLengthOfProbabilities(size);
+}
+
+// Compute the offset of the first state of each `size` into the packed
+// probabilities.
+static int* createSizeOffsets(int maxSize) {
+  int* sizeOffsets = calloc(maxSize + 2, sizeof(int));
+
+  for (int size = 0; size <= maxSize; size++) {
+    sizeOffsets[size + 1] = sizeOffsets[size] + (size + 1) * getNumberOutcomes(size);
+  }
+
+  return sizeOffsets;
+}
+
+int getOutcomeOffset(struct outcomeTable* table, int size, int numberLower) {
+  return table->sizeOffsets[size] + numberLower * getNumberOutcomes(size);
+}
+
+int getNumberOutcomeValues(struct outcomeTable* table) {
+  return table->sizeOffsets[table->maxSize + 1];
+}
+
+double* getOutcomeProbabilities(struct outcomeTable* table, int size, int numberLower) {
+  return table->probabilities + getOutcomeOffset(table, size, numberLower);
+}
+
+// Fill in the outcome probabilities of every state, from the smallest
+// decks up. This is the same dynamic algorithm as in prob.c, but run
+// backwards from the end of the game, so that each state reuses the
+// outcomes of the states it can lead to.
+//
+// The outcome at index n of a state is that the computer predicts
+// correctly for the next (n + 1) deals. For n = 0 this is the
+// probability of predicting the next deal correctly. Otherwise the
+// next deal must be correct, and from the state (size - 1, position)
+// it leads to, the following n deals must be predicted correctly,
+// which is that state's outcome at index (n - 1).
+//
+// The correct deals from a state form a single range of positions,
+// so the sums over them are differences of prefix sums over the
+// outcomes of the smaller deck.
+static void calculateOutcomeTable(struct outcomeTable* table) {
+  int maxSize = table->maxSize;
+  double* prefixSums = calloc(maxSize + 2, sizeof(double));
+
+  for (int size = 2; size <= maxSize; size++) {
+    int numberOutcomes = getNumberOutcomes(size);
+
+    for (int n = 0; n < numberOutcomes; n++) {
+      // prefixSums[i] is the sum over the positions below i of the
+      // probability of the remaining n deals being correct from the
+      // state they lead to.
+      for (int position = 0; position < size; position++) {
+        double remaining = n == 0 ? 1 : getOutcomeProbabilities(table, size - 1, position)[n - 1];
+
+        prefixSums[position + 1] = prefixSums[position] + remaining;
+      }
+
+      for (int numberLower = 0; numberLower <= size; numberLower++) {
+        double sum = predictsHigher(size, numberLower)
+          ? prefixSums[size] - prefixSums[numberLower]
+          : prefixSums[numberLower];
+
+        getOutcomeProbabilities(table, size, numberLower)[n] = sum / size;
+      }
+    }
+  }
+
+  free(prefixSums);
+}
+
+struct outcomeTable* createOutcomeTable(int maxSize) {
+  struct outcomeTable* table = malloc(sizeof(struct outcomeTable));
+
+  table->maxSize = maxSize;
+  table->sizeOffsets = createSizeOffsets(maxSize);
+  table->probabilities = calloc(getNumberOutcomeValues(table), sizeof(double));
+
+  calculateOutcomeTable(table);
+
+  return table;
+}
+
+void freeOutcomeTable(struct outcomeTable* table) {
+  free(table->sizeOffsets);
+  free(table->probabilities);
+  free(table);
+}
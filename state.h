@@ -0,0 +1,59 @@
+// A game state is characterised by the number of cards remaining in
+// the deck, `size`, and the number of those cards which are lower
+// than the last card played, `numberLower`. See prob.c for the
+// outline of the game.
+
+// Does the computer predict that the next dealt card will be higher?
+// See prob.c for the computer's heuristic: if there are at least as
+// many cards higher than the last played card as there are lower,
+// predict higher. Otherwise predict lower. This and the next function
+// are inline, as the exact engines call them in their innermost loops.
+static inline int predictsHigher(int size, int numberLower) {
+  int numberHigher = size - numberLower;
+
+  return numberHigher >= numberLower;
+}
+
+// The computer predicts higher exactly from the states with `size`
+// cards and fewer than this many lower: by `predictsHigher`, when
+// numberLower <= size - numberLower, that is when numberLower is at
+// most size / 2.
+static inline int getHigherPredictionLimit(int size) {
+  return size / 2 + 1;
+}
+
+// Dealing the card which has `position` remaining cards lower than it
+// leads to the state (size - 1, position). Is the computer's
+// prediction correct for this deal?
+int isCorrectPrediction(int size, int numberLower, int position);
+
+// States are packed triangularly, ordered by `size` and then by
+// `numberLower`, with 0 <= numberLower <= size.
+int getStateIndex(int size, int numberLower);
+
+// The number of states with a `size` of at most `maxSize`.
+int getNumberStates(int maxSize);
+
+// The probabilities of the outcomes <Card 1 or further, ...> (see
+// prob.c) for every state with a `size` of at most `maxSize`, packed
+// contiguously.
+struct outcomeTable {
+  int maxSize;
+  int* sizeOffsets;
+  double* probabilities;
+};
+
+struct outcomeTable* createOutcomeTable(int maxSize);
+
+void freeOutcomeTable(struct outcomeTable* table);
+
+// A pointer to the getLengthOfProbabilities(size) outcome
+// probabilities of the given state.
+double* getOutcomeProbabilities(struct outcomeTable* table, int size, int numberLower);
+
+// The offset of those probabilities into `probabilities`, for packing
+// other values per outcome in the same way.
+int getOutcomeOffset(struct outcomeTable* table, int size, int numberLower);
+
+// The number of values packed in this way.
+int getNumberOutcomeValues(struct outcomeTable* table);
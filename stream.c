@@ -0,0 +1,82 @@
+#include <stdlib.h>
+#include <float.h>
+#include "prob.h"
+#include "stream.h"
+#include "state.h"
+#include "paths.h"
+
+// The matrix in prob.c keeps a row of path counts for every stage, but
+// each row is only used to compute the next one and the outcome of its
+// own stage. Here we keep a single row, of the probability that every
+// deal so far has been predicted correctly and that the game is now in
+// the state with j cards lower than the last card, and advance it in
+// place one stage at a time. Counts would overflow for large decks, so
+// the row holds probabilities, and each deal divides by the number of
+// cards it could have dealt.
+//
+// The row is advanced as the path counts in paths.h are, and then
+// divided by the number of cards the deal could have dealt. The
+// outcome at index n is the sum of the row after (n + 1) deals.
+// Summing the row directly, rather than the probabilities of failing
+// at each stage afterwards, keeps the relative error of even the
+// smallest outcomes small.
+//
+// The probability of a long streak shrinks geometrically, so for a
+// large deck most outcomes are too small to represent. Once the whole
+// row is below the smallest normal double, every later outcome is
+// emitted as 0, which is within DBL_MIN of the truth, and the rest of
+// the deck is never computed.
+
+DEFINE_PATH_DEAL(dealPaths, double)
+
+// Advance the row by one deal from the states with `m` cards left, and
+// return the sum of the new row.
+static double deal(double* row, double* prefixSums, int m) {
+  double sum = dealPaths(row, prefixSums, m);
+
+  for (int j = 0; j < m; j++) {
+    row[j] /= m;
+  }
+
+  return sum / m;
+}
+
+void streamProbabilities(int size,
+                         int numberLower,
+                         void (*emit)(void* context, int outcome, double probability),
+                         void* context) {
+  double* row = calloc(size + 1, sizeof(double));
+  double* prefixSums = calloc(size + 2, sizeof(double));
+  int lengthOfProbabilities = getLengthOfProbabilities(size);
+  int n = 0;
+
+  row[numberLower] = 1;
+
+  for (; n < lengthOfProbabilities; n++) {
+    double sum = deal(row, prefixSums, size - n);
+
+    emit(context, n, sum);
+
+    if (sum < DBL_MIN) {
+      n++;
+      break;
+    }
+  }
+
+  for (; n < lengthOfProbabilities; n++) {
+    emit(context, n, 0);
+  }
+
+  free(row);
+  free(prefixSums);
+}
+
+static void store(void* context, int outcome, double probability) {
+  double* probabilitiesResult = context;
+
+  probabilitiesResult[outcome] = probability;
+}
+
+void calculateStreamedProbabilities(double* probabilitiesResult, int size, int numberLower) {
+  streamProbabilities(size, numberLower, store, probabilitiesResult);
+}
@@ -0,0 +1,11 @@
+// Outcome probabilities for decks far too large for the exact engines,
+// computed in double precision in O(size) memory. Each outcome is
+// passed to `emit` as soon as it is known, in order, so that the
+// getLengthOfProbabilities(size) probabilities need not be stored.
+void streamProbabilities(int size,
+                         int numberLower,
+                         void (*emit)(void* context, int outcome, double probability),
+                         void* context);
+
+// The same probabilities collected into `probabilitiesResult`.
+void calculateStreamedProbabilities(double* probabilitiesResult, int size, int numberLower);
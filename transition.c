@@ -0,0 +1,105 @@
+#include <stdlib.h>
+#include "prob.h"
+#include "state.h"
+#include "transition.h"
+
+// A state of `size` cards has (size + 1) values of `numberLower`, each
+// with `size` possible next cards. The transitions of all states of
+// one size therefore take up (size + 1) * size places, and their
+// outcome probabilities (size - 1) times that.
+//
+// Once the next card is dealt, the outcome at index n of the parent
+// state is decided by whether that deal and the following n deals are
+// predicted correctly. If the deal was predicted wrongly, every
+// outcome is lost. Otherwise, the outcome at index 0 is won, and the
+// one at index n > 0 has the probability of the child's outcome at
+// index (n - 1).
+
+static int getNumberTransitions(int size) {
+  return size < 2 ? 0 : (size + 1) * size;
+}
+
+static int getNumberOutcomes(int size) {
+  return size < 2 ? 0 : getLengthOfProbabilities(size);
+}
+
+static int getTransitionIndex(struct transitionTable* table, int size, int numberLower, int position) {
+  return table->transitionOffsets[size] + numberLower * size + position;
+}
+
+struct transition* getTransition(struct transitionTable* table,
+                                 int size,
+                                 int numberLower,
+                                 int position) {
+  return &table->transitions[getTransitionIndex(table, size, numberLower, position)];
+}
+
+double* getTransitionProbabilities(struct transitionTable* table,
+                                   int size,
+                                   int numberLower,
+                                   int position) {
+  int index = getTransitionIndex(table, size, numberLower, position) - table->transitionOffsets[size];
+
+  return &table->probabilities[table->probabilityOffsets[size] + index * getNumberOutcomes(size)];
+}
+
+static void fillTransition(struct transitionTable* table, int size, int numberLower, int position) {
+  struct transition* transition = getTransition(table, size, numberLower, position);
+  double* probabilities = getTransitionProbabilities(table, size, numberLower, position);
+  int correct = isCorrectPrediction(size, numberLower, position);
+
+  transition->childSize = size - 1;
+  transition->childNumberLower = position;
+  transition->correct = correct;
+
+  if (!correct) {
+    return;
+  }
+
+  double* childProbabilities = getOutcomeProbabilities(table->outcomes, size - 1, position);
+
+  probabilities[0] = 1;
+
+  for (int n = 1; n < getNumberOutcomes(size); n++) {
+    probabilities[n] = childProbabilities[n - 1];
+  }
+}
+
+struct transitionTable* createTransitionTable(int maxSize) {
+  struct transitionTable* table = malloc(sizeof(struct transitionTable));
+
+  table->maxSize = maxSize;
+  table->transitionOffsets = calloc(maxSize + 2, sizeof(int));
+  table->probabilityOffsets = calloc(maxSize + 2, sizeof(int));
+
+  for (int size = 0; size <= maxSize; size++) {
+    int numberTransitions = getNumberTransitions(size);
+
+    table->transitionOffsets[size + 1] = table->transitionOffsets[size] + numberTransitions;
+    table->probabilityOffsets[size + 1] = table->probabilityOffsets[size]
+      + numberTransitions * getNumberOutcomes(size);
+  }
+
+  table->transitions = calloc(table->transitionOffsets[maxSize + 1], sizeof(struct transition));
+  table->probabilities = calloc(table->probabilityOffsets[maxSize + 1], sizeof(double));
+  table->outcomes = createOutcomeTable(maxSize);
+
+  for (int size = 2; size <= maxSize; size++) {
+    for (int numberLower = 0; numberLower <= size; numberLower++) {
+      for (int position = 0; position < size; position++) {
+        fillTransition(table, size, numberLower, position);
+      }
+    }
+  }
+
+  return table;
+}
+
+void freeTransitionTable(struct transitionTable* table) {
+  free(table->transitionOffsets);
+  free(table->probabilityOffsets);
+  free(table->transitions);
+  free(table->probabilities);
+  freeOutcomeTable(table->outcomes);
+  free(table);
+}
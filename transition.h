@@ -0,0 +1,39 @@
+// For every state with a `size` of at most `maxSize` (see state.h),
+// and every position the next card could have among the remaining
+// cards, the state that card leads to, and the probabilities of the
+// state's outcomes once it has been dealt. All of these are packed
+// contiguously, and looked up in constant time.
+
+struct transition {
+  int childSize;
+  int childNumberLower;
+  int correct;
+};
+
+struct transitionTable {
+  int maxSize;
+  int* transitionOffsets;
+  int* probabilityOffsets;
+  struct transition* transitions;
+  double* probabilities;
+  struct outcomeTable* outcomes;
+};
+
+struct transitionTable* createTransitionTable(int maxSize);
+
+void freeTransitionTable(struct transitionTable* table);
+
+// Dealing the card which has `position` remaining cards lower than it,
+// from the state (size, numberLower), with size >= 2.
+struct transition* getTransition(struct transitionTable* table,
+                                 int size,
+                                 int numberLower,
+                                 int position);
+
+// The getLengthOfProbabilities(size) probabilities of the outcomes of
+// the state (size, numberLower), in the same order, after that card
+// has been dealt.
+double* getTransitionProbabilities(struct transitionTable* table,
+                                   int size,
+                                   int numberLower,
+                                   int position);
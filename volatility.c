@@ -0,0 +1,100 @@
+#include <stdlib.h>
+#include <math.h>
+#include "prob.h"
+#include "state.h"
+#include "transition.h"
+#include "volatility.h"
+
+// The probabilities of an outcome after each possible next card are in
+// the transition table, each card being dealt with probability
+// 1 / size. This gives the next deal statistics directly.
+//
+// For the rest of the game, if the next deal settles the outcome,
+// which it does when the deal is predicted wrongly or the outcome is
+// at index 0, the rest of the game is just the next deal. Otherwise
+// the outcome at index n carries on as the outcome at index (n - 1)
+// of the child state. So the mean of the total change is the mean over
+// the next deal plus the average of the children's means, and likewise
+// for the variance. The changes over successive deals are uncorrelated,
+// so their variances add up. The probability of an outcome is a
+// martingale, so every mean is 0 up to rounding, and every variance of
+// the total change is p * (1 - p).
+//
+// Children have one card fewer than their parents, so the statistics
+// of all states are computed in one pass from the smallest deck up.
+
+int getVolatilityIndex(struct volatilityTable* table, int size, int numberLower, int outcome) {
+  return getOutcomeOffset(table->transitions->outcomes, size, numberLower) + outcome;
+}
+
+static void calculateStatistics(struct volatilityTable* table, int size, int numberLower, int outcome) {
+  struct transitionTable* transitions = table->transitions;
+  double probability = getOutcomeProbabilities(transitions->outcomes, size, numberLower)[outcome];
+  double nextMean = 0;
+  double nextVariance = 0;
+  double nextMaxMove = 0;
+  double restMean = 0;
+  double restVariance = 0;
+  double restMaxMove = 0;
+
+  for (int position = 0; position < size; position++) {
+    double move = getTransitionProbabilities(transitions, size, numberLower, position)[outcome] - probability;
+
+    nextMean += move / size;
+    nextVariance += (move * move) / size;
+    nextMaxMove = fmax(nextMaxMove, fabs(move));
+
+    if (outcome > 0 && getTransition(transitions, size, numberLower, position)->correct) {
+      int child = getVolatilityIndex(table, size - 1, position, outcome - 1);
+
+      restMean += table->restMeans[child] / size;
+      restVariance += table->restVariances[child] / size;
+      restMaxMove = fmax(restMaxMove, table->restMaxMoves[child]);
+    }
+  }
+
+  int index = getVolatilityIndex(table, size, numberLower, outcome);
+
+  table->nextMeans[index] = nextMean;
+  table->nextVariances[index] = nextVariance;
+  table->nextMaxMoves[index] = nextMaxMove;
+  table->restMeans[index] = nextMean + restMean;
+  table->restVariances[index] = nextVariance + restVariance;
+  table->restMaxMoves[index] = fmax(nextMaxMove, restMaxMove);
+}
+
+struct volatilityTable* createVolatilityTable(int maxSize) {
+  struct volatilityTable* table = malloc(sizeof(struct volatilityTable));
+
+  table->transitions = createTransitionTable(maxSize);
+
+  int length = getNumberOutcomeValues(table->transitions->outcomes);
+
+  table->nextMeans = calloc(length, sizeof(double));
+  table->nextVariances = calloc(length, sizeof(double));
+  table->nextMaxMoves = calloc(length, sizeof(double));
+  table->restMeans = calloc(length, sizeof(double));
+  table->restVariances = calloc(length, sizeof(double));
+  table->restMaxMoves = calloc(length, sizeof(double));
+
+  for (int size = 2; size <= maxSize; size++) {
+    for (int numberLower = 0; numberLower <= size; numberLower++) {
+      for (int outcome = 0; outcome < getLengthOfProbabilities(size); outcome++) {
+        calculateStatistics(table, size, numberLower, outcome);
+      }
+    }
+  }
+
+  return table;
+}
+
+void freeVolatilityTable(struct volatilityTable* table) {
+  freeTransitionTable(table->transitions);
+  free(table->nextMeans);
+  free(table->nextVariances);
+  free(table->nextMaxMoves);
+  free(table->restMeans);
+  free(table->restVariances);
+  free(table->restMaxMoves);
+  free(table);
+}
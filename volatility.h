@@ -0,0 +1,27 @@
+// Statistics of how the probability of each outcome moves, for every
+// state with a `size` of at most `maxSize`, packed in the same way as
+// the outcome table (see `getOutcomeOffset` in state.h).
+//
+// The `next` statistics are of the change in the probability over the
+// next deal. The `rest` statistics are over the rest of the game, up
+// to the deal which settles the outcome: the mean and variance of the
+// total change, and the largest change over any single deal which can
+// happen on the way.
+
+struct volatilityTable {
+  struct transitionTable* transitions;
+  double* nextMeans;
+  double* nextVariances;
+  double* nextMaxMoves;
+  double* restMeans;
+  double* restVariances;
+  double* restMaxMoves;
+};
+
+struct volatilityTable* createVolatilityTable(int maxSize);
+
+void freeVolatilityTable(struct volatilityTable* table);
+
+// The index of the statistics of an outcome of the state (size,
+// numberLower) into the arrays of the table.
+int getVolatilityIndex(struct volatilityTable* table, int size, int numberLower, int outcome);
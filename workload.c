@@ -0,0 +1,33 @@
+#include "rng.h"
+#include "state.h"
+#include "workload.h"
+
+// A game starts with no card played, in the state (size, 0), and every
+// deal is a uniformly random one of the remaining cards. The guide is
+// asked for prices at every stage while there are outcomes left to bet
+// on: until the computer's prediction fails, or fewer than two cards
+// remain. So the mix is weighted towards the early, large states of
+// the game, and towards the states which follow correct predictions,
+// as it is in play.
+void generateWorkload(struct query* queries, int numberQueries, int size, uint64_t seed) {
+  struct randomState random;
+  int currentSize = size;
+  int numberLower = 0;
+
+  seedRandom(&random, seed);
+
+  for (int i = 0; i < numberQueries; i++) {
+    queries[i].size = currentSize;
+    queries[i].numberLower = numberLower;
+
+    int position = nextRandomBelow(&random, currentSize);
+
+    if (isCorrectPrediction(currentSize, numberLower, position) && currentSize > 2) {
+      currentSize--;
+      numberLower = position;
+    } else {
+      currentSize = size;
+      numberLower = 0;
+    }
+  }
+}
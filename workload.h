@@ -0,0 +1,12 @@
+#include <stdint.h>
+
+// A game state which the betting guide is asked to price.
+struct query {
+  int size;
+  int numberLower;
+};
+
+// Fill `queries` with the states that arise in play, in the order and
+// with the frequency they arise, from games of `size` cards dealt with
+// the random stream seeded by `seed`.
+void generateWorkload(struct query* queries, int numberQueries, int size, uint64_t seed);